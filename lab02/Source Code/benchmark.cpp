@@ -0,0 +1,925 @@
+#include <opencv2/opencv.hpp>
+#include <opencv2/imgproc.hpp>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#include "blob_core.hpp"
+#include "dog_detector.hpp"
+#include "fast_hessian.hpp"
+#include "harris_core.hpp"
+#include "harris_fixed.hpp"
+#include "harris_kernel.hpp"
+#include "harris_sparse.hpp"
+#include "keypoint_select.hpp"
+#include "lbp_descriptor.hpp"
+#include "pair_extract.hpp"
+
+using namespace cv;
+using namespace std;
+
+// Function prototypes
+void showHelp();
+void benchResponse(const vector<string>& images);
+void benchTiled(const vector<string>& images);
+void benchBox(const vector<string>& images);
+void benchKernels(const vector<string>& images);
+bool benchFixed(const vector<string>& images);
+void benchSparse(const vector<string>& images);
+void benchPairs(const vector<string>& images);
+void benchGrouping(const vector<string>& images);
+void benchLevels(const vector<string>& images);
+void benchComponents(const vector<string>& images);
+void benchHessian(const vector<string>& images);
+void benchDoG(const vector<string>& images);
+void benchLBP(const vector<string>& images);
+
+const int ITERATIONS = 20;
+
+// Average wall-clock time of one call, in milliseconds
+template<typename F>
+double timeMs(F fn, int iterations = ITERATIONS) {
+    fn(); // warm-up (allocations, caches)
+    int64 start = getTickCount();
+    for (int i = 0; i < iterations; i++) fn();
+    return (getTickCount() - start) * 1000.0 / getTickFrequency() / iterations;
+}
+
+double megapixelsPerSec(const Size& size, double ms) {
+    return ms > 0 ? size.area() / (ms * 1000.0) : 0;
+}
+
+bool loadGray(const string& path, Mat& gray) {
+    Mat img = imread(path, IMREAD_GRAYSCALE);
+    if (img.empty()) {
+        cerr << "Error: Cannot open image " << path << endl;
+        return false;
+    }
+    gray = img;
+    return true;
+}
+
+// Structure tensor with the default lab parameters (block 2, aperture 3)
+void structureTensor(const Mat& gray, Mat& Sxx, Mat& Syy, Mat& Sxy) {
+    Mat Ix, Iy, Ixx, Iyy, Ixy;
+    Sobel(gray, Ix, CV_32F, 1, 0, 3);
+    Sobel(gray, Iy, CV_32F, 0, 1, 3);
+    multiply(Ix, Ix, Ixx); multiply(Iy, Iy, Iyy); multiply(Ix, Iy, Ixy);
+    GaussianBlur(Ixx, Sxx, Size(5, 5), 0);
+    GaussianBlur(Iyy, Syy, Size(5, 5), 0);
+    GaussianBlur(Ixy, Sxy, Size(5, 5), 0);
+}
+
+// Reference: the per-pixel at<float> loop the tools used before harris_core.hpp
+void legacyHarrisResponse(const Mat& Sxx, const Mat& Syy, const Mat& Sxy, Mat& harris, double k) {
+    harris.create(Sxx.size(), CV_32F);
+    for (int i = 0; i < Sxx.rows; i++) {
+        for (int j = 0; j < Sxx.cols; j++) {
+            float sxx = Sxx.at<float>(i,j), syy = Syy.at<float>(i,j), sxy = Sxy.at<float>(i,j);
+            harris.at<float>(i,j) = sxx * syy - sxy * sxy - k * (sxx + syy) * (sxx + syy);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        showHelp();
+        return -1;
+    }
+
+    string command = argv[1];
+    vector<string> images(argv + 2, argv + argc);
+
+    if (command == "response") benchResponse(images);
+    else if (command == "tiled") benchTiled(images);
+    else if (command == "box") benchBox(images);
+    else if (command == "kernels") benchKernels(images);
+    else if (command == "sparse") benchSparse(images);
+    else if (command == "pairs") benchPairs(images);
+    else if (command == "grouping") benchGrouping(images);
+    else if (command == "levels") benchLevels(images);
+    else if (command == "components") benchComponents(images);
+    else if (command == "hessian") benchHessian(images);
+    else if (command == "dog") benchDoG(images);
+    else if (command == "lbp") benchLBP(images);
+    else if (command == "fixed") {
+        if (!benchFixed(images)) return 1;
+    }
+    else {
+        cerr << "Unknown benchmark: " << command << endl;
+        showHelp();
+        return -1;
+    }
+    return 0;
+}
+
+void showHelp() {
+    cout << "\n========== CV Lab Benchmarks ==========" << endl;
+    cout << "Usage: ./benchmark <command> <image> [image...]" << endl;
+    cout << "\nCOMMANDS:" << endl;
+    cout << "  response   - Harris response: per-pixel loop vs SIMD row kernel" << endl;
+    cout << "  tiled      - Tiled Harris thread scaling (1..N threads, native and 20 MP)" << endl;
+    cout << "  box        - Gaussian vs integral-image box window, block sizes 2-10" << endl;
+    cout << "  kernels    - Generic pipeline vs HarrisKernel<Aperture, Block> (3/5/7 x 2-10)" << endl;
+    cout << "  fixed      - Fixed-point vs float Harris: speed and equivalence (exit 1 on mismatch)" << endl;
+    cout << "  sparse     - Coarse-to-fine vs dense Harris keypoints: recall and speedup" << endl;
+    cout << "  pairs      - Matching-pair extraction, sequential vs concurrent (images in the" << endl;
+    cout << "               same folder are paired in order), per detector/descriptor" << endl;
+    cout << "  grouping   - Blob center grouping: exhaustive scan vs spatial hash" << endl;
+    cout << "  levels     - Multi-threshold contour extraction, serial vs parallel levels" << endl;
+    cout << "               with histogram-collapsed levels (native and low contrast)" << endl;
+    cout << "  components - Component tree (all levels, steps 20/10/5) vs per-level contours" << endl;
+    cout << "  hessian    - Fast-Hessian vs SimpleBlobDetector latency, cost per filter size" << endl;
+    cout << "  dog        - In-project DoG detector vs SIFT::detect: latency, stages, 1 thread," << endl;
+    cout << "               and how many SIFT keypoints it reproduces" << endl;
+    cout << "  lbp        - LBP descriptor throughput: per-patch coding vs shared code image;" << endl;
+    cout << "               integral histogram build, memory and cost per patch size" << endl;
+    cout << "=======================================\n" << endl;
+}
+
+void benchResponse(const vector<string>& images) {
+    const double k = 0.04;
+    cout << "Harris response kernel (" << ITERATIONS << " iterations, k=" << k << ")" << endl;
+    cout << left << setw(40) << "image" << setw(12) << "size"
+         << setw(14) << "loop MP/s" << setw(14) << "simd MP/s"
+         << setw(10) << "speedup" << "max rel diff" << endl;
+
+    for (size_t n = 0; n < images.size(); n++) {
+        Mat gray;
+        if (!loadGray(images[n], gray)) continue;
+
+        Mat Sxx, Syy, Sxy;
+        structureTensor(gray, Sxx, Syy, Sxy);
+
+        Mat legacy, simd;
+        double loopMs = timeMs([&]() { legacyHarrisResponse(Sxx, Syy, Sxy, legacy, k); });
+        double simdMs = timeMs([&]() { computeHarrisResponse(Sxx, Syy, Sxy, simd, k); });
+
+        double scale = norm(legacy, NORM_INF);
+        double relDiff = scale > 0 ? norm(legacy, simd, NORM_INF) / scale : 0;
+
+        cout << left << setw(40) << images[n]
+             << setw(12) << (to_string(gray.cols) + "x" + to_string(gray.rows))
+             << setw(14) << fixed << setprecision(1) << megapixelsPerSec(gray.size(), loopMs)
+             << setw(14) << megapixelsPerSec(gray.size(), simdMs)
+             << setw(10) << setprecision(2) << (simdMs > 0 ? loopMs / simdMs : 0)
+             << scientific << setprecision(2) << relDiff << endl;
+        cout.unsetf(ios::floatfield);
+    }
+}
+
+void benchTiled(const vector<string>& images) {
+    const int blockSize = 2, apertureSize = 3;
+    const double k = 0.04;
+    const int iterations = 5;
+    const int maxThreads = getNumberOfCPUs();
+
+    // 1, 2, 4, ... plus the full machine
+    vector<int> threadCounts;
+    for (int t = 1; t < maxThreads; t *= 2) threadCounts.push_back(t);
+    threadCounts.push_back(maxThreads);
+
+    cout << "Tiled Harris scaling (block " << blockSize << ", aperture " << apertureSize
+         << ", " << maxThreads << " CPUs)" << endl;
+
+    for (size_t n = 0; n < images.size(); n++) {
+        Mat gray;
+        if (!loadGray(images[n], gray)) continue;
+
+        // Native resolution plus a ~20 MP upscale to mimic large stills
+        vector<Mat> inputs(1, gray);
+        double upscale = sqrt(20e6 / gray.size().area());
+        if (upscale > 1.0) {
+            Mat big;
+            resize(gray, big, Size(), upscale, upscale, INTER_LINEAR);
+            inputs.push_back(big);
+        }
+
+        for (size_t v = 0; v < inputs.size(); v++) {
+            const Mat& img = inputs[v];
+            Mat serial, tiled;
+
+            setNumThreads(1);
+            double serialMs = timeMs([&]() { computeHarris(img, serial, blockSize, apertureSize, k); }, iterations);
+
+            cout << images[n] << " " << img.cols << "x" << img.rows
+                 << "  serial: " << fixed << setprecision(1) << serialMs << " ms" << endl;
+
+            for (size_t t = 0; t < threadCounts.size(); t++) {
+                setNumThreads(threadCounts[t]);
+                double tiledMs = timeMs([&]() { computeHarrisTiled(img, tiled, blockSize, apertureSize, k); }, iterations);
+                bool identical = norm(serial, tiled, NORM_INF) == 0;
+                cout << "  threads " << setw(3) << threadCounts[t]
+                     << "  " << setw(8) << tiledMs << " ms"
+                     << "  speedup " << setprecision(2) << serialMs / tiledMs << "x"
+                     << "  " << (identical ? "bit-identical" : "MISMATCH") << setprecision(1) << endl;
+            }
+            cout.unsetf(ios::floatfield);
+        }
+    }
+    setNumThreads(-1);
+}
+
+void benchBox(const vector<string>& images) {
+    const int apertureSize = 3;
+    const double k = 0.04;
+    const int iterations = 5;
+
+    // Single-threaded so the window cost is not hidden by OpenCV's pool
+    setNumThreads(1);
+    cout << "Harris window cost (aperture " << apertureSize << ", serial, "
+         << iterations << " iterations)" << endl;
+
+    for (size_t n = 0; n < images.size(); n++) {
+        Mat gray;
+        if (!loadGray(images[n], gray)) continue;
+
+        cout << images[n] << " " << gray.cols << "x" << gray.rows << endl;
+        cout << "  " << left << setw(8) << "block" << setw(10) << "window"
+             << setw(14) << "gauss ms" << setw(14) << "box ms" << "speedup" << endl;
+
+        for (int blockSize = 2; blockSize <= 10; blockSize++) {
+            Mat gauss, box;
+            double gaussMs = timeMs([&]() {
+                computeHarris(gray, gauss, blockSize, apertureSize, k, HARRIS_WINDOW_GAUSSIAN);
+            }, iterations);
+            double boxMs = timeMs([&]() {
+                computeHarris(gray, box, blockSize, apertureSize, k, HARRIS_WINDOW_BOX);
+            }, iterations);
+
+            int side = 2 * blockSize + 1;
+            cout << "  " << setw(8) << blockSize
+                 << setw(10) << (to_string(side) + "x" + to_string(side))
+                 << setw(14) << fixed << setprecision(1) << gaussMs
+                 << setw(14) << boxMs
+                 << setprecision(2) << gaussMs / boxMs << "x" << endl;
+        }
+        cout.unsetf(ios::floatfield);
+    }
+    setNumThreads(-1);
+}
+
+void benchKernels(const vector<string>& images) {
+    const double k = 0.04;
+    const int iterations = 5;
+    const int apertures[] = { 3, 5, 7 };
+
+    // Single-threaded: compares the code paths, not the thread pool
+    setNumThreads(1);
+    cout << "Specialized Harris kernels (serial, " << iterations << " iterations)" << endl;
+
+    for (size_t n = 0; n < images.size(); n++) {
+        Mat gray;
+        if (!loadGray(images[n], gray)) continue;
+
+        cout << images[n] << " " << gray.cols << "x" << gray.rows << endl;
+        cout << "  " << left << setw(10) << "aperture" << setw(8) << "block"
+             << setw(14) << "generic ms" << setw(14) << "kernel ms"
+             << setw(10) << "speedup" << "max rel diff" << endl;
+
+        for (int a = 0; a < 3; a++) {
+            for (int blockSize = 2; blockSize <= 10; blockSize++) {
+                int apertureSize = apertures[a];
+                Mat generic, specialized;
+                double genericMs = timeMs([&]() {
+                    computeHarris(gray, generic, blockSize, apertureSize, k);
+                }, iterations);
+                double kernelMs = timeMs([&]() {
+                    computeHarrisSpecialized(gray, specialized, blockSize, apertureSize, k);
+                }, iterations);
+
+                double scale = norm(generic, NORM_INF);
+                double relDiff = scale > 0 ? norm(generic, specialized, NORM_INF) / scale : 0;
+
+                cout << "  " << setw(10) << apertureSize << setw(8) << blockSize
+                     << setw(14) << fixed << setprecision(1) << genericMs
+                     << setw(14) << kernelMs
+                     << setw(10) << setprecision(2) << genericMs / kernelMs
+                     << scientific << relDiff << endl;
+                cout.unsetf(ios::floatfield);
+            }
+        }
+    }
+    setNumThreads(-1);
+}
+
+// Fraction of the strongest `count` local maxima of `a` found at the same
+// positions among those of `b`
+double topCornerAgreement(const Mat& a, const Mat& b, int count) {
+    vector<KeyPoint> ka, kb;
+    selectKeypointsNMS(a, 0, 1, count, ka);
+    selectKeypointsNMS(b, 0, 1, count, kb);
+    if (ka.empty()) return 1.0;
+
+    Mat hits = Mat::zeros(a.size(), CV_8U);
+    for (size_t i = 0; i < kb.size(); i++) hits.at<uchar>(kb[i].pt) = 1;
+    int same = 0;
+    for (size_t i = 0; i < ka.size(); i++) same += hits.at<uchar>(ka[i].pt);
+    return (double)same / ka.size();
+}
+
+bool benchFixed(const vector<string>& images) {
+    const int apertureSize = 3;
+    const double k = 0.04;
+    const int iterations = 10;
+    const int topCorners = 500;
+    bool allEquivalent = true;
+
+    setNumThreads(1);
+    cout << "Fixed-point Harris vs float (aperture " << apertureSize << ", serial, "
+         << iterations << " iterations, top " << topCorners << " corners)" << endl;
+    cout << left << setw(40) << "image" << setw(8) << "block"
+         << setw(12) << "float ms" << setw(12) << "fixed ms" << setw(10) << "speedup"
+         << setw(14) << "max rel diff" << setw(12) << "top agree" << "result" << endl;
+
+    for (size_t n = 0; n < images.size(); n++) {
+        Mat gray;
+        if (!loadGray(images[n], gray)) continue;
+
+        for (int blockSize = 1; blockSize <= 2; blockSize++) {
+            Mat ref, fixedResp;
+            double floatMs = timeMs([&]() { computeHarris(gray, ref, blockSize, apertureSize, k); }, iterations);
+            double fixedMs = timeMs([&]() { computeHarrisFixed(gray, fixedResp, blockSize, apertureSize, k); }, iterations);
+
+            double scale = norm(ref, NORM_INF);
+            double relDiff = scale > 0 ? norm(ref, fixedResp, NORM_INF) / scale : 0;
+            double agree = topCornerAgreement(ref, fixedResp, topCorners);
+            // Same ranking up to float rounding: near-ties may swap at the cut
+            bool equivalent = relDiff < 1e-5 && agree >= 0.99;
+            allEquivalent = allEquivalent && equivalent;
+
+            cout << left << setw(40) << images[n] << setw(8) << blockSize
+                 << setw(12) << fixed << setprecision(2) << floatMs
+                 << setw(12) << fixedMs
+                 << setw(10) << floatMs / fixedMs
+                 << setw(14) << scientific << relDiff
+                 << setw(12) << fixed << setprecision(3) << agree
+                 << (equivalent ? "OK" : "MISMATCH") << endl;
+            cout.unsetf(ios::floatfield);
+        }
+    }
+    setNumThreads(-1);
+    cout << (allEquivalent ? "Fixed-point path equivalent on all images"
+                           : "Fixed-point path MISMATCH") << endl;
+    return allEquivalent;
+}
+
+void benchSparse(const vector<string>& images) {
+    const int blockSize = 2, apertureSize = 3, nmsRadius = 2, maxKeypoints = 2000;
+    const double k = 0.04, threshold = 200;
+    const int iterations = 5;
+
+    cout << "Sparse coarse-to-fine Harris vs dense (block " << blockSize << ", threshold "
+         << threshold << ", NMS " << 2 * nmsRadius + 1 << "x" << 2 * nmsRadius + 1 << ")" << endl;
+
+    for (size_t n = 0; n < images.size(); n++) {
+        Mat gray;
+        if (!loadGray(images[n], gray)) continue;
+
+        // Native resolution plus a ~20 MP upscale (large stills)
+        vector<Mat> inputs(1, gray);
+        double upscale = sqrt(20e6 / gray.size().area());
+        if (upscale > 1.0) {
+            Mat big;
+            resize(gray, big, Size(), upscale, upscale, INTER_LINEAR);
+            inputs.push_back(big);
+        }
+
+        for (size_t v = 0; v < inputs.size(); v++) {
+            const Mat& img = inputs[v];
+            vector<KeyPoint> dense, sparse;
+            HarrisSparseResult result;
+
+            double denseMs = timeMs([&]() {
+                Mat harris;
+                computeHarrisTiled(img, harris, blockSize, apertureSize, k);
+                selectKeypointsNMS(harris, normalizedThreshold(harris, threshold), nmsRadius, maxKeypoints, dense);
+            }, iterations);
+            double sparseMs = timeMs([&]() {
+                computeHarrisSparse(img, result, blockSize, apertureSize, k);
+                float cutoff = normalizedThreshold(result.minResponse, result.maxResponse, threshold);
+                selectKeypointsNMS(result.response, cutoff, nmsRadius, maxKeypoints, sparse);
+            }, iterations);
+
+            // Recall: dense keypoints with a sparse keypoint within 1 pixel
+            Mat hits = Mat::zeros(img.size(), CV_8U);
+            for (size_t i = 0; i < sparse.size(); i++) {
+                circle(hits, Point(cvRound(sparse[i].pt.x), cvRound(sparse[i].pt.y)), 1, Scalar(1), -1);
+            }
+            int found = 0;
+            for (size_t i = 0; i < dense.size(); i++) {
+                found += hits.at<uchar>(Point(cvRound(dense[i].pt.x), cvRound(dense[i].pt.y)));
+            }
+            double recall = dense.empty() ? 1.0 : (double)found / dense.size();
+
+            cout << images[n] << " " << img.cols << "x" << img.rows << fixed << setprecision(1)
+                 << "  dense " << denseMs << " ms (" << dense.size() << " kp)"
+                 << "  sparse " << sparseMs << " ms (" << sparse.size() << " kp, "
+                 << result.tilesEvaluated << "/" << result.tilesTotal << " tiles)"
+                 << "  speedup " << setprecision(2) << denseMs / sparseMs << "x"
+                 << "  recall " << setprecision(3) << recall << endl;
+            cout.unsetf(ios::floatfield);
+        }
+    }
+}
+
+// Reference: cvlab's per-patch LBP descriptor before lbp_descriptor.hpp
+// (40x40 patch recoded per keypoint, 256-bin normalized histogram)
+Mat patchLBPDescriptor(const Mat& gray, Point2f center) {
+    int patchSize = 40;
+    int x = cvRound(center.x), y = cvRound(center.y);
+    int x1 = max(0, x - patchSize/2), y1 = max(0, y - patchSize/2);
+    int x2 = min(gray.cols, x + patchSize/2), y2 = min(gray.rows, y + patchSize/2);
+    if (x2 <= x1 + 5 || y2 <= y1 + 5) return Mat();
+
+    Mat patch = gray(Rect(x1, y1, x2-x1, y2-y1));
+    Mat lbp = Mat::zeros(patch.size(), CV_8U);
+    for (int i = 1; i < patch.rows - 1; i++) {
+        for (int j = 1; j < patch.cols - 1; j++) {
+            uchar c = patch.at<uchar>(i, j), code = 0;
+            code |= (patch.at<uchar>(i-1,j) >= c) << 7;
+            code |= (patch.at<uchar>(i-1,j+1) >= c) << 6;
+            code |= (patch.at<uchar>(i,j+1) >= c) << 5;
+            code |= (patch.at<uchar>(i+1,j+1) >= c) << 4;
+            code |= (patch.at<uchar>(i+1,j) >= c) << 3;
+            code |= (patch.at<uchar>(i+1,j-1) >= c) << 2;
+            code |= (patch.at<uchar>(i,j-1) >= c) << 1;
+            code |= (patch.at<uchar>(i-1,j-1) >= c) << 0;
+            lbp.at<uchar>(i,j) = code;
+        }
+    }
+
+    int histSize = 256;
+    float range[] = {0, 256};
+    const float* histRange = {range};
+    Mat hist;
+    calcHist(&lbp, 1, 0, Mat(), hist, 1, &histSize, &histRange);
+    hist += 1e-7;
+    hist /= cv::sum(hist)[0];
+    return hist.reshape(1, 1);
+}
+
+// Keypoint and descriptor extraction of one cvlab matching combination
+void extractCombination(int detector, int descriptor, const Mat& gray,
+                        vector<KeyPoint>& kp, Mat& desc) {
+    const int budget = 500;
+    if (detector == 0) {            // Harris: tiled, 5x5 NMS, spread budget
+        Mat harris;
+        computeHarrisTiled(gray, harris, 2, 3, 0.04);
+        selectKeypointsNMS(harris, normalizedThreshold(harris, 200), 2, 4 * budget, kp);
+        distributeKeypoints(kp, gray.size(), budget);
+    } else if (detector == 1) {     // DoG
+        SIFT::create()->detect(gray, kp);
+        distributeKeypoints(kp, gray.size(), budget);
+    } else {                        // Blob
+        SimpleBlobDetector::Params params;
+        params.minThreshold = 10; params.maxThreshold = 220;
+        params.filterByArea = true; params.minArea = 100;
+        params.filterByCircularity = true; params.minCircularity = 0.04f;
+        params.filterByConvexity = true; params.minConvexity = 0.58f;
+        SimpleBlobDetector::create(params)->detect(gray, kp);
+        distributeKeypoints(kp, gray.size(), budget);
+    }
+
+    if (descriptor == 0) {
+        SIFT::create()->compute(gray, kp, desc);
+    } else {
+        Mat codes;
+        computeLBPCodes(gray, codes);
+        computeLBPDescriptors(codes, kp, desc);
+    }
+}
+
+string parentDir(const string& path) {
+    size_t slash = path.find_last_of('/');
+    return slash == string::npos ? "" : path.substr(0, slash);
+}
+
+void benchPairs(const vector<string>& images) {
+    const char* detectors[] = { "harris", "dog", "blob" };
+    const char* descriptors[] = { "sift", "lbp" };
+    const int iterations = 5;
+
+    cout << "Matching-pair extraction: sequential vs concurrent (" << iterations
+         << " iterations, " << getNumThreads() << " threads)" << endl;
+
+    double totalSeq[3][2] = {}, totalPar[3][2] = {};
+    for (size_t n = 0; n + 1 < images.size(); n++) {
+        if (parentDir(images[n]) != parentDir(images[n + 1])) continue;
+        Mat gray1, gray2;
+        if (!loadGray(images[n], gray1) || !loadGray(images[n + 1], gray2)) continue;
+        cout << images[n] << " + " << images[n + 1] << endl;
+
+        for (int det = 0; det < 3; det++) {
+            for (int des = 0; des < 2; des++) {
+                vector<KeyPoint> kp1, kp2, cp1, cp2;
+                Mat d1, d2, c1, c2;
+                auto extract = [&](const Mat& gray, vector<KeyPoint>& kp, Mat& desc) {
+                    extractCombination(det, des, gray, kp, desc);
+                };
+                double seqMs = timeMs([&]() { extractPair(gray1, gray2, kp1, kp2, d1, d2, extract, false); }, iterations);
+                double parMs = timeMs([&]() { extractPair(gray1, gray2, cp1, cp2, c1, c2, extract, true); }, iterations);
+                totalSeq[det][des] += seqMs;
+                totalPar[det][des] += parMs;
+
+                bool same = kp1.size() == cp1.size() && kp2.size() == cp2.size() &&
+                            d1.size() == c1.size() && d2.size() == c2.size() &&
+                            (d1.empty() || norm(d1, c1, NORM_INF) == 0) &&
+                            (d2.empty() || norm(d2, c2, NORM_INF) == 0);
+                cout << "  " << left << setw(14) << (string(detectors[det]) + "+" + descriptors[des])
+                     << fixed << setprecision(1)
+                     << "sequential " << setw(9) << seqMs << "concurrent " << setw(9) << parMs
+                     << "speedup " << setprecision(2) << (parMs > 0 ? seqMs / parMs : 0) << "x"
+                     << (same ? "" : "  OUTPUT DIFFERS") << endl;
+                cout.unsetf(ios::floatfield);
+            }
+        }
+    }
+
+    cout << "Total per combination:" << endl;
+    for (int det = 0; det < 3; det++) {
+        for (int des = 0; des < 2; des++) {
+            if (totalPar[det][des] <= 0) continue;
+            cout << "  " << left << setw(14) << (string(detectors[det]) + "+" + descriptors[des])
+                 << fixed << setprecision(2) << totalSeq[det][des] / totalPar[det][des] << "x" << endl;
+            cout.unsetf(ios::floatfield);
+        }
+    }
+}
+
+// Reference: exercise_b's original Step 3, every grouped point is checked
+void legacyGroupCenters(const vector<vector<Point2f>>& allCenters, vector<vector<Point2f>>& blobGroups) {
+    blobGroups.clear();
+    for (size_t i = 0; i < allCenters.size(); i++) {
+        for (size_t j = 0; j < allCenters[i].size(); j++) {
+            Point2f center = allCenters[i][j];
+            bool foundGroup = false;
+            for (size_t g = 0; g < blobGroups.size() && !foundGroup; g++) {
+                for (size_t k = 0; k < blobGroups[g].size(); k++) {
+                    float dist = norm(center - blobGroups[g][k]);
+                    if (dist < 5.0) {
+                        blobGroups[g].push_back(center);
+                        foundGroup = true;
+                        break;
+                    }
+                }
+            }
+            if (!foundGroup) blobGroups.push_back(vector<Point2f>(1, center));
+        }
+    }
+}
+
+// Centers of every contour with area >= minArea, per threshold level
+void levelCenters(const Mat& gray, int thresholdStep, double minArea, vector<vector<Point2f>>& centers) {
+    centers.clear();
+    for (int thresh = 10; thresh < 220; thresh += thresholdStep) {
+        LevelContours level;
+        extractLevel(gray, thresh, 255, level);
+        centers.push_back(vector<Point2f>());
+        for (size_t i = 0; i < level.contours.size(); i++) {
+            const Moments& m = level.moments[i];
+            if (level.areas[i] < minArea || m.m00 == 0) continue;
+            centers.back().push_back(Point2f((float)(m.m10 / m.m00), (float)(m.m01 / m.m00)));
+        }
+    }
+}
+
+void benchGrouping(const vector<string>& images) {
+    const float radius = 5.0f;
+    const int thresholdStep = 20;
+
+    // Landmark images with exercise_b's defaults, plus blurred noise with no
+    // area filter: thousands of contours per level
+    vector<string> names;
+    vector<Mat> inputs;
+    vector<double> minAreas;
+    for (size_t n = 0; n < images.size(); n++) {
+        Mat gray;
+        if (!loadGray(images[n], gray)) continue;
+        names.push_back(images[n]);
+        inputs.push_back(gray);
+        minAreas.push_back(100);
+    }
+    Mat noise(768, 1024, CV_8U), texture;
+    RNG rng(12345);
+    rng.fill(noise, RNG::UNIFORM, Scalar(0), Scalar(256));
+    GaussianBlur(noise, texture, Size(), 4);
+    normalize(texture, texture, 0, 255, NORM_MINMAX);
+    names.push_back("synthetic texture");
+    inputs.push_back(texture);
+    minAreas.push_back(0);
+
+    cout << "Blob center grouping across threshold levels (radius " << radius
+         << ", step " << thresholdStep << ")" << endl;
+
+    for (size_t n = 0; n < inputs.size(); n++) {
+        vector<vector<Point2f>> centers, legacy, hashed;
+        levelCenters(inputs[n], thresholdStep, minAreas[n], centers);
+        size_t total = 0;
+        for (size_t l = 0; l < centers.size(); l++) total += centers[l].size();
+
+        double legacyMs = timeMs([&]() { legacyGroupCenters(centers, legacy); }, 1);
+        double hashMs = timeMs([&]() { groupBlobCenters(centers, radius, hashed); });
+
+        bool same = legacy.size() == hashed.size();
+        for (size_t g = 0; same && g < legacy.size(); g++) {
+            same = legacy[g].size() == hashed[g].size() &&
+                   equal(legacy[g].begin(), legacy[g].end(), hashed[g].begin());
+        }
+
+        cout << names[n] << fixed << setprecision(1)
+             << "  " << (double)total / max((size_t)1, centers.size()) << " centers/level, "
+             << legacy.size() << " groups"
+             << "  exhaustive " << legacyMs << " ms  hash " << setprecision(3) << hashMs << " ms"
+             << "  speedup " << setprecision(1) << (hashMs > 0 ? legacyMs / hashMs : 0) << "x"
+             << (same ? "  identical" : "  GROUPS DIFFER") << endl;
+        cout.unsetf(ios::floatfield);
+    }
+}
+
+bool sameLevels(const vector<LevelContours>& a, const vector<LevelContours>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t l = 0; l < a.size(); l++) {
+        if (a[l].contours != b[l].contours || a[l].areas != b[l].areas) return false;
+    }
+    return true;
+}
+
+void benchLevels(const vector<string>& images) {
+    const int steps[] = { 20, 10, 5 };
+
+    cout << "Contour extraction over thresholds 10..220, bright blobs ("
+         << getNumThreads() << " threads); 'low contrast' squeezes the image into 96..159" << endl;
+
+    for (size_t n = 0; n < images.size(); n++) {
+        Mat gray;
+        if (!loadGray(images[n], gray)) continue;
+        Mat lowContrast;
+        gray.convertTo(lowContrast, -1, 0.25, 96);
+
+        for (int variant = 0; variant < 2; variant++) {
+            const Mat& input = variant == 0 ? gray : lowContrast;
+            cout << images[n] << (variant == 0 ? "" : " low contrast")
+                 << " (" << input.cols << "x" << input.rows << ")" << endl;
+
+            for (int s = 0; s < 3; s++) {
+                vector<int> thresholds;
+                for (int thresh = 10; thresh < 220; thresh += steps[s]) thresholds.push_back(thresh);
+
+                // Reference: exercise_b's original loop, one level after another
+                vector<LevelContours> serial, parallel;
+                double serialMs = timeMs([&]() {
+                    serial.clear();
+                    for (size_t i = 0; i < thresholds.size(); i++) {
+                        serial.push_back(LevelContours());
+                        extractLevel(input, thresholds[i], 255, serial.back());
+                    }
+                }, 5);
+                int collapsed = 0;
+                double parallelMs = timeMs([&]() { collapsed = extractLevels(input, thresholds, 255, parallel); }, 5);
+
+                cout << "  step " << setw(2) << steps[s] << " (" << setw(2) << thresholds.size() << " levels, "
+                     << setw(2) << collapsed << " collapsed)"
+                     << fixed << setprecision(2)
+                     << "  serial " << setw(8) << serialMs << " ms"
+                     << "  parallel " << setw(8) << parallelMs << " ms"
+                     << "  speedup " << setprecision(1) << (parallelMs > 0 ? serialMs / parallelMs : 0) << "x"
+                     << (sameLevels(serial, parallel) ? "  identical" : "  LEVELS DIFFER") << endl;
+                cout.unsetf(ios::floatfield);
+            }
+        }
+    }
+}
+
+// Components of one level agree with connectedComponentsWithStats (areas and
+// centroids, compared as sorted lists)
+bool matchesConnectedComponents(const Mat& gray, int thresh, const LevelComponents& level) {
+    Mat binary, labels, stats, centroids;
+    threshold(gray, binary, thresh, 255, THRESH_BINARY);
+    int count = connectedComponentsWithStats(binary, labels, stats, centroids, 8) - 1;  // minus background
+    if (count != (int)level.areas.size()) return false;
+
+    vector<Vec3d> expected, actual;
+    for (int i = 1; i <= count; i++) {
+        expected.push_back(Vec3d(stats.at<int>(i, CC_STAT_AREA), centroids.at<double>(i, 0), centroids.at<double>(i, 1)));
+        actual.push_back(Vec3d(level.areas[i - 1], level.centers[i - 1].x, level.centers[i - 1].y));
+    }
+    auto byArea = [](const Vec3d& a, const Vec3d& b) {
+        return a[0] != b[0] ? a[0] < b[0] : a[1] != b[1] ? a[1] < b[1] : a[2] < b[2];
+    };
+    sort(expected.begin(), expected.end(), byArea);
+    sort(actual.begin(), actual.end(), byArea);
+    for (int i = 0; i < count; i++) {
+        if (expected[i][0] != actual[i][0] || norm(expected[i] - actual[i]) > 1e-3) return false;
+    }
+    return true;
+}
+
+void benchComponents(const vector<string>& images) {
+    const int steps[] = { 20, 10, 5 };
+
+    cout << "Blob levels over thresholds 10..220, bright blobs: threshold + findContours"
+         << " per level at step 20 vs one component tree" << endl;
+
+    for (size_t n = 0; n < images.size(); n++) {
+        Mat gray;
+        if (!loadGray(images[n], gray)) continue;
+
+        vector<int> coarse;
+        for (int thresh = 10; thresh < 220; thresh += 20) coarse.push_back(thresh);
+        vector<LevelContours> contours;
+        double contourMs = timeMs([&]() { extractLevels(gray, coarse, 255, contours); }, 5);
+
+        cout << images[n] << " (" << gray.cols << "x" << gray.rows << ")" << fixed << setprecision(2)
+             << "  contours, step 20: " << contourMs << " ms" << endl;
+        for (int s = 0; s < 3; s++) {
+            vector<int> thresholds;
+            for (int thresh = 10; thresh < 220; thresh += steps[s]) thresholds.push_back(thresh);
+
+            vector<LevelComponents> levels;
+            double treeMs = timeMs([&]() { componentLevels(gray, thresholds, 255, levels); }, 5);
+
+            size_t components = 0;
+            for (size_t l = 0; l < levels.size(); l++) components += levels[l].areas.size();
+            bool same = true;
+            for (size_t l = 0; l < levels.size() && same; l += 3) {
+                same = matchesConnectedComponents(gray, thresholds[l], levels[l]);
+            }
+
+            cout << "  tree, step " << setw(2) << steps[s] << " (" << setw(2) << thresholds.size() << " levels): "
+                 << setw(8) << treeMs << " ms  " << setw(7) << components << " components"
+                 << "  vs contours " << setprecision(1) << (treeMs > 0 ? contourMs / treeMs : 0) << "x"
+                 << (same ? "  matches connectedComponents" : "  COMPONENTS DIFFER") << setprecision(2) << endl;
+        }
+        cout.unsetf(ios::floatfield);
+    }
+}
+
+void benchHessian(const vector<string>& images) {
+    // cvlab's blob parameters
+    SimpleBlobDetector::Params params;
+    params.minThreshold = 10; params.maxThreshold = 220;
+    params.filterByArea = true; params.minArea = 100;
+    params.filterByCircularity = true; params.minCircularity = 0.04f;
+    params.filterByConvexity = true; params.minConvexity = 0.58f;
+    params.filterByInertia = true; params.minInertiaRatio = 0.1f;
+
+    cout << "Blob detection latency: SimpleBlobDetector (cvlab parameters) vs Fast-Hessian"
+         << " (threshold 100, 4 octaves); single layers at step 1 for filter sizes 9..99" << endl;
+
+    const int filterSizes[] = { 9, 27, 51, 99 };
+    for (size_t n = 0; n < images.size(); n++) {
+        Mat gray;
+        if (!loadGray(images[n], gray)) continue;
+
+        vector<KeyPoint> blobs, hessian;
+        double blobMs = timeMs([&]() { SimpleBlobDetector::create(params)->detect(gray, blobs); }, 5);
+        double hessianMs = timeMs([&]() { detectFastHessian(gray, hessian, 100, 4); }, 5);
+
+        cout << images[n] << " (" << gray.cols << "x" << gray.rows << ")" << fixed << setprecision(2)
+             << "  SimpleBlobDetector " << setw(8) << blobMs << " ms (" << blobs.size() << ")"
+             << "  Fast-Hessian " << setw(8) << hessianMs << " ms (" << hessian.size() << ")"
+             << "  speedup " << setprecision(1) << (hessianMs > 0 ? blobMs / hessianMs : 0) << "x" << endl;
+
+        // Box sums make a response cost the same at every filter size
+        Mat sum;
+        integral(gray, sum, CV_64F);
+        cout << "  layer cost:";
+        for (int f = 0; f < 4; f++) {
+            HessianLayer layer;
+            layer.filterSize = filterSizes[f];
+            layer.step = 1;
+            double layerMs = timeMs([&]() { fastHessianLayer<double>(sum, layer); }, 5);
+            cout << "  " << filterSizes[f] << "px " << setprecision(2) << layerMs << " ms";
+        }
+        cout << endl;
+        cout.unsetf(ios::floatfield);
+    }
+}
+
+// Share of `reference` keypoints with a `found` keypoint within 1 px and 10%
+// of its size (both lists as SIFT::detect reports them)
+double keypointRecall(const vector<KeyPoint>& reference, vector<KeyPoint> found) {
+    if (reference.empty()) return 1;
+    sort(found.begin(), found.end(), [](const KeyPoint& a, const KeyPoint& b) { return a.pt.x < b.pt.x; });
+    int matched = 0;
+    for (const KeyPoint& kp : reference) {
+        auto it = lower_bound(found.begin(), found.end(), kp.pt.x - 1.f,
+                              [](const KeyPoint& a, float x) { return a.pt.x < x; });
+        for (; it != found.end() && it->pt.x <= kp.pt.x + 1.f; ++it) {
+            if (abs(it->pt.y - kp.pt.y) <= 1.f && abs(it->size - kp.size) <= 0.1f * kp.size) {
+                matched++;
+                break;
+            }
+        }
+    }
+    return (double)matched / reference.size();
+}
+
+void benchDoG(const vector<string>& images) {
+    cout << "DoG detection latency: SIFT::detect vs dog_detector.hpp (SIFT defaults: 3 layers,"
+         << " contrast 0.04, edge 10, sigma 1.6, " << getNumThreads() << " threads)" << endl;
+
+    for (size_t n = 0; n < images.size(); n++) {
+        Mat gray;
+        if (!loadGray(images[n], gray)) continue;
+
+        vector<KeyPoint> reference, native;
+        Ptr<SIFT> sift = SIFT::create();
+        double siftMs = timeMs([&]() { sift->detect(gray, reference); }, 5);
+        double nativeMs = timeMs([&]() { detectDoGNative(gray, native); }, 5);
+
+        cout << images[n] << " (" << gray.cols << "x" << gray.rows << ")" << fixed << setprecision(2)
+             << "  SIFT " << setw(8) << siftMs << " ms (" << reference.size() << ")"
+             << "  native " << setw(8) << nativeMs << " ms (" << native.size() << ")"
+             << "  speedup " << setprecision(1) << (nativeMs > 0 ? siftMs / nativeMs : 0) << "x"
+             << "  recall " << setprecision(1) << 100 * keypointRecall(reference, native) << "%" << endl;
+
+        // Stages, and what the thread pool buys
+        DoGPyramid pyr;
+        vector<DoGCandidate> candidates;
+        double pyramidMs = timeMs([&]() { buildDoGPyramid(gray, pyr); }, 5);
+        double candidateMs = timeMs([&]() { findDoGCandidates(pyr, 0.04, candidates); }, 5);
+        double filterMs = timeMs([&]() { filterDoGCandidates(candidates, 3, 0.04, 10, native); }, 5);
+        setNumThreads(1);
+        double serialSiftMs = timeMs([&]() { sift->detect(gray, reference); }, 5);
+        double serialMs = timeMs([&]() { detectDoGNative(gray, native); }, 5);
+        setNumThreads(-1);
+
+        cout << setprecision(2) << "  stages: pyramid " << pyramidMs << " ms (" << pyr.nOctaves << " octaves)"
+             << ", extrema " << candidateMs << " ms (" << candidates.size() << " candidates)"
+             << ", filter " << filterMs << " ms" << endl;
+        cout << "  1 thread: SIFT " << serialSiftMs << " ms, native " << serialMs << " ms" << endl;
+        cout.unsetf(ios::floatfield);
+    }
+}
+
+void benchLBP(const vector<string>& images) {
+    cout << "LBP descriptor extraction: per-patch coding vs one code image + histograms"
+         << " (SIFT keypoints: cvlab budget of 500, and all)" << endl;
+
+    for (size_t n = 0; n < images.size(); n++) {
+        Mat gray;
+        if (!loadGray(images[n], gray)) continue;
+        cout << images[n] << " (" << gray.cols << "x" << gray.rows << ")" << endl;
+
+        vector<KeyPoint> all;
+        SIFT::create()->detect(gray, all);
+        vector<KeyPoint> budget = all;
+        distributeKeypoints(budget, gray.size(), 500);
+
+        Mat codes;
+        double codesMs = timeMs([&]() { computeLBPCodes(gray, codes); });
+        cout << fixed << setprecision(2) << "  code image " << codesMs << " ms ("
+             << megapixelsPerSec(gray.size(), codesMs) << " MP/s)" << endl;
+
+        const vector<KeyPoint>* sets[] = { &budget, &all };
+        for (int s = 0; s < 2; s++) {
+            const vector<KeyPoint>& kp = *sets[s];
+            if (kp.empty()) continue;
+            Mat reference((int)kp.size(), LBP_BINS, CV_32F, Scalar(0)), shared;
+            double patchMs = timeMs([&]() {
+                for (size_t i = 0; i < kp.size(); i++) {
+                    Mat d = patchLBPDescriptor(gray, kp[i].pt);
+                    if (!d.empty()) d.copyTo(reference.row((int)i));
+                }
+            }, 5);
+            double histMs = timeMs([&]() { computeLBPDescriptors(codes, kp, shared); }, 5);
+            double sharedMs = codesMs + histMs;
+
+            cout << "  " << setw(6) << kp.size() << " keypoints  per-patch " << setw(8) << patchMs << " ms ("
+                 << setprecision(0) << setw(7) << kp.size() * 1000.0 / patchMs << " kp/s)"
+                 << setprecision(2) << "  shared " << setw(8) << sharedMs << " ms ("
+                 << setprecision(0) << setw(7) << kp.size() * 1000.0 / sharedMs << " kp/s, histograms "
+                 << setprecision(2) << histMs << " ms)"
+                 << "  speedup " << setprecision(1) << (sharedMs > 0 ? patchMs / sharedMs : 0) << "x"
+                 << "  max diff " << scientific << setprecision(1) << norm(reference, shared, NORM_INF)
+                 << endl;
+            cout.unsetf(ios::floatfield);
+        }
+
+        // Integral histogram: build cost, memory, and patch size no longer
+        // driving the per-keypoint cost
+        LBPIntegralHistogram integral;
+        double integralMs = timeMs([&]() { buildLBPIntegralHistogram(codes, integral); }, 5);
+        setNumThreads(1);
+        double serialIntegralMs = timeMs([&]() { buildLBPIntegralHistogram(codes, integral); }, 5);
+        setNumThreads(-1);
+        cout << fixed << setprecision(2) << "  integral histogram (" << LBP_UNIFORM_BINS << " bins) "
+             << integralMs << " ms, 1 thread " << serialIntegralMs << " ms, "
+             << integral.bytes() / (1024 * 1024) << " MB" << endl;
+
+        if (all.empty()) continue;
+        const int patchSizes[] = { 20, 40, 80, 160 };
+        cout << "  " << all.size() << " keypoints, histograms per patch size:";
+        for (int p = 0; p < 4; p++) {
+            Mat desc;
+            double codesHistMs = timeMs([&]() { computeLBPDescriptors(codes, all, desc, patchSizes[p]); }, 5);
+            double integralHistMs = timeMs([&]() { computeLBPDescriptors(integral, all, desc, patchSizes[p]); }, 5);
+            cout << "  " << patchSizes[p] << "px " << codesHistMs << " / " << integralHistMs << " ms";
+        }
+        cout << " (code image / integral)" << endl;
+        cout.unsetf(ios::floatfield);
+    }
+}
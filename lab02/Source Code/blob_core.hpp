@@ -0,0 +1,390 @@
+#ifndef BLOB_CORE_HPP
+#define BLOB_CORE_HPP
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Shared building blocks of the manual multi-threshold blob detector
+// (exercise_b): per-level contour extraction, a component tree for all
+// levels at once, grouping of blob centers across levels and a centroid
+// index for contour lookups.
+
+// Contours of one binary level with the per-contour values the filters use.
+// centers[i] is the centroid, valid only when moments[i].m00 != 0.
+struct LevelContours {
+    std::vector<std::vector<cv::Point> > contours;
+    std::vector<double> areas;
+    std::vector<cv::Moments> moments;
+    std::vector<cv::Point2f> centers;
+};
+
+// Threshold at `thresh` (bright blobs when blobColor is 255, dark otherwise)
+// and collect the contours with their areas and moments. `binary` is scratch
+// space, reused across calls on the same thread.
+inline void extractLevel(const cv::Mat& gray, int thresh, int blobColor, LevelContours& level,
+                         cv::Mat& binary) {
+    cv::threshold(gray, binary, thresh, 255, blobColor == 255 ? cv::THRESH_BINARY : cv::THRESH_BINARY_INV);
+    cv::findContours(binary, level.contours, cv::RETR_LIST, cv::CHAIN_APPROX_SIMPLE);
+
+    level.areas.resize(level.contours.size());
+    level.moments.resize(level.contours.size());
+    level.centers.assign(level.contours.size(), cv::Point2f());
+    for (size_t i = 0; i < level.contours.size(); i++) {
+        level.areas[i] = cv::contourArea(level.contours[i]);
+        const cv::Moments& m = level.moments[i] = cv::moments(level.contours[i]);
+        if (m.m00 != 0) level.centers[i] = cv::Point2f(m.m10 / m.m00, m.m01 / m.m00);
+    }
+}
+
+inline void extractLevel(const cv::Mat& gray, int thresh, int blobColor, LevelContours& level) {
+    cv::Mat binary;
+    extractLevel(gray, thresh, blobColor, level, binary);
+}
+
+// Two thresholds give the same binary image (for either blob color) when no
+// pixel intensity lies between them, i.e. when the cumulative histogram is
+// equal at both. From one histogram pass, source[l] is the first level with
+// the same binary image as level l (l itself for a new one). Returns the
+// number of levels that repeat an earlier one.
+inline int collapseLevels(const cv::Mat& gray, const std::vector<int>& thresholds, std::vector<int>& source) {
+    CV_Assert(gray.type() == CV_8UC1);
+    int cumulative[256] = { 0 };
+    for (int y = 0; y < gray.rows; y++) {
+        const uchar* row = gray.ptr<uchar>(y);
+        for (int x = 0; x < gray.cols; x++) cumulative[row[x]]++;
+    }
+    for (int v = 1; v < 256; v++) cumulative[v] += cumulative[v - 1];
+
+    // Pixels at or below each threshold identify its binary image
+    std::vector<int> below(thresholds.size());
+    for (size_t l = 0; l < thresholds.size(); l++) {
+        int t = thresholds[l];
+        below[l] = t < 0 ? 0 : cumulative[std::min(t, 255)];
+    }
+
+    int collapsed = 0;
+    source.resize(thresholds.size());
+    for (size_t l = 0; l < thresholds.size(); l++) {
+        source[l] = (int)l;
+        for (size_t e = 0; e < l; e++) {
+            if (below[e] == below[l]) {
+                source[l] = (int)e;
+                collapsed++;
+                break;
+            }
+        }
+    }
+    return collapsed;
+}
+
+// extractLevel() for every entry of `thresholds`, levels[i] for thresholds[i].
+// Levels that collapse onto an earlier one (collapseLevels) copy its
+// contours instead of being extracted again. The others are independent, so
+// they are spread over cv::parallel_for_; each worker reuses one binary
+// buffer for its range and writes only its own slots of the pre-sized
+// output, so the result is the same as a serial loop in any thread count.
+// Returns the number of collapsed levels.
+inline int extractLevels(const cv::Mat& gray, const std::vector<int>& thresholds, int blobColor,
+                         std::vector<LevelContours>& levels) {
+    std::vector<int> source, distinct;
+    int collapsed = collapseLevels(gray, thresholds, source);
+    for (size_t l = 0; l < thresholds.size(); l++) {
+        if (source[l] == (int)l) distinct.push_back((int)l);
+    }
+
+    levels.resize(thresholds.size());
+    cv::parallel_for_(cv::Range(0, (int)distinct.size()), [&](const cv::Range& range) {
+        cv::Mat binary;
+        for (int i = range.start; i < range.end; i++) {
+            extractLevel(gray, thresholds[distinct[i]], blobColor, levels[distinct[i]], binary);
+        }
+    });
+    for (size_t l = 0; l < thresholds.size(); l++) {
+        if (source[l] != (int)l) levels[l] = levels[source[l]];
+    }
+    return collapsed;
+}
+
+// Connected components of one threshold level: pixel areas, centroids and
+// second-order central moments (mu20, mu11, mu02)
+struct LevelComponents {
+    std::vector<double> areas;
+    std::vector<cv::Point2f> centers;
+    std::vector<cv::Vec3d> mu;
+};
+
+// 8-connected foreground components of every level in `thresholds` (same
+// foreground as extractLevel: gray > t for bright blobs, gray <= t for dark)
+// from a single component tree, MSER-style. Pixels are counting-sorted in
+// the order they join the foreground as the threshold sweeps, then added one
+// by one to a union-find forest whose roots accumulate raw moments. A
+// level's components are read off the live roots once all of its pixels
+// are in, so the cost is one pass over the image plus the live components
+// per level, instead of threshold + findContours per level.
+//
+// Unlike the contours, areas are pixel counts and holes do not produce
+// components of their own. The counting sort doubles as the intensity
+// histogram: a level whose threshold adds no pixels to the previous one
+// (no intensity in between) copies that level's components. Returns the
+// number of levels collapsed that way.
+inline int componentLevels(const cv::Mat& gray, const std::vector<int>& thresholds, int blobColor,
+                            std::vector<LevelComponents>& levels) {
+    CV_Assert(gray.type() == CV_8UC1);
+    const int rows = gray.rows, cols = gray.cols, total = rows * cols;
+    const bool bright = blobColor == 255;
+
+    // Sweep key: a pixel is foreground at threshold t when key <= cut(t)
+    std::vector<uchar> key(total);
+    int start[257] = { 0 };
+    for (int y = 0; y < rows; y++) {
+        const uchar* src = gray.ptr<uchar>(y);
+        uchar* dst = &key[y * cols];
+        for (int x = 0; x < cols; x++) {
+            dst[x] = bright ? (uchar)(255 - src[x]) : src[x];
+            start[dst[x] + 1]++;
+        }
+    }
+    for (int v = 0; v < 256; v++) start[v + 1] += start[v];
+    std::vector<int> order(total);
+    {
+        int fill[256];
+        std::copy(start, start + 256, fill);
+        for (int i = 0; i < total; i++) order[fill[key[i]]++] = i;
+    }
+
+    std::vector<int> byCut(thresholds.size()), cuts(thresholds.size());
+    for (size_t l = 0; l < thresholds.size(); l++) {
+        cuts[l] = bright ? 254 - thresholds[l] : thresholds[l];
+        byCut[l] = (int)l;
+    }
+    std::stable_sort(byCut.begin(), byCut.end(), [&](int a, int b) { return cuts[a] < cuts[b]; });
+
+    // Union-find over pixel indices (-1: not in the foreground yet). Each
+    // root owns a slot of raw moment sums; merged-away slots are recycled.
+    struct Sums { int64 n, sx, sy, sxx, sxy, syy; };
+    std::vector<int> parent(total, -1), slotOf(total, -1), freeSlots;
+    std::vector<Sums> sums;
+    auto find = [&](int p) {
+        while (parent[p] != p) {
+            parent[p] = parent[parent[p]];
+            p = parent[p];
+        }
+        return p;
+    };
+
+    levels.assign(thresholds.size(), LevelComponents());
+    int added = 0, collapsed = 0;
+    for (size_t c = 0; c < byCut.size(); c++) {
+        const int cut = cuts[byCut[c]];
+        const int end = cut < 0 ? 0 : start[std::min(cut, 255) + 1];
+        if (c > 0 && end == added) {
+            levels[byCut[c]] = levels[byCut[c - 1]];
+            collapsed++;
+            continue;
+        }
+
+        for (; added < end; added++) {
+            const int p = order[added], x = p % cols, y = p / cols;
+            int slot;
+            if (freeSlots.empty()) {
+                slot = (int)sums.size();
+                sums.push_back(Sums());
+            } else {
+                slot = freeSlots.back();
+                freeSlots.pop_back();
+            }
+            Sums s = { 1, x, y, (int64)x * x, (int64)x * y, (int64)y * y };
+            sums[slot] = s;
+            parent[p] = p;
+            slotOf[p] = slot;
+
+            int root = p;
+            for (int dy = -1; dy <= 1; dy++) {
+                if (y + dy < 0 || y + dy >= rows) continue;
+                for (int dx = -1; dx <= 1; dx++) {
+                    if ((dx == 0 && dy == 0) || x + dx < 0 || x + dx >= cols) continue;
+                    const int q = p + dy * cols + dx;
+                    if (parent[q] < 0) continue;
+                    int other = find(q);
+                    if (other == root) continue;
+
+                    // Union by size: the larger component keeps its root
+                    if (sums[slotOf[root]].n < sums[slotOf[other]].n) std::swap(root, other);
+                    Sums& keep = sums[slotOf[root]];
+                    Sums& gone = sums[slotOf[other]];
+                    keep.n += gone.n; keep.sx += gone.sx; keep.sy += gone.sy;
+                    keep.sxx += gone.sxx; keep.sxy += gone.sxy; keep.syy += gone.syy;
+                    gone.n = 0;
+                    freeSlots.push_back(slotOf[other]);
+                    parent[other] = root;
+                }
+            }
+        }
+
+        // Live slots are exactly the components at this level
+        LevelComponents& level = levels[byCut[c]];
+        for (size_t i = 0; i < sums.size(); i++) {
+            const Sums& s = sums[i];
+            if (s.n == 0) continue;
+            double n = (double)s.n, cx = s.sx / n, cy = s.sy / n;
+            level.areas.push_back(n);
+            level.centers.push_back(cv::Point2f((float)cx, (float)cy));
+            level.mu.push_back(cv::Vec3d(s.sxx - cx * s.sx, s.sxy - cx * s.sy, s.syy - cy * s.sy));
+        }
+    }
+    return collapsed;
+}
+
+// Ratio of the minimum to the maximum inertia of a shape from its central
+// second-order moments (1 for a circle, toward 0 for a line), as in
+// SimpleBlobDetector's filterByInertia
+inline double inertiaRatio(double mu20, double mu11, double mu02) {
+    double denominator = std::sqrt(std::pow(2 * mu11, 2) + std::pow(mu20 - mu02, 2));
+    if (denominator <= 1e-2) return 1.0;
+    double cosmin = (mu20 - mu02) / denominator;
+    double sinmin = 2 * mu11 / denominator;
+    double imin = 0.5 * (mu20 + mu02) - 0.5 * (mu20 - mu02) * cosmin - mu11 * sinmin;
+    double imax = 0.5 * (mu20 + mu02) + 0.5 * (mu20 - mu02) * cosmin + mu11 * sinmin;
+    return imin / imax;
+}
+
+// Uniform grid over the centroids of a level's contours (per-cell linked
+// lists, as in groupBlobCenters) for nearest-contour queries. Contours with
+// zero area moments have no centroid and are left out. The level must
+// outlive the index.
+class CentroidGrid {
+public:
+    CentroidGrid() : level(0), cell(1.f), minX(0), minY(0), gridW(0), gridH(0) {}
+
+    void build(const LevelContours& source, float cellSize) {
+        level = &source;
+        cell = cellSize;
+        head.clear();
+        next.assign(source.centers.size(), -1);
+        gridW = gridH = 0;
+
+        bool any = false;
+        float maxX = 0, maxY = 0;
+        for (size_t i = 0; i < source.centers.size(); i++) {
+            if (source.moments[i].m00 == 0) continue;
+            const cv::Point2f& p = source.centers[i];
+            if (!any) { minX = maxX = p.x; minY = maxY = p.y; any = true; continue; }
+            minX = std::min(minX, p.x); maxX = std::max(maxX, p.x);
+            minY = std::min(minY, p.y); maxY = std::max(maxY, p.y);
+        }
+        if (!any) return;
+
+        gridW = (int)((maxX - minX) / cell) + 1;
+        gridH = (int)((maxY - minY) / cell) + 1;
+        head.assign((size_t)gridW * gridH, -1);
+        // Insert in reverse so every cell lists its contours in index order
+        for (int i = (int)source.centers.size() - 1; i >= 0; i--) {
+            if (source.moments[i].m00 == 0) continue;
+            int c = cellOf(source.centers[i]);
+            next[i] = head[c];
+            head[c] = i;
+        }
+    }
+
+    // Contour whose centroid is nearest to p, if it is at most maxDist away
+    // (lowest index on ties, like a linear scan with "<"); -1 otherwise
+    int nearest(const cv::Point2f& p, double maxDist, double* distance = 0) const {
+        if (head.empty()) return -1;
+        int reach = (int)std::ceil(maxDist / cell);
+        int cx = (int)std::floor((p.x - minX) / cell), cy = (int)std::floor((p.y - minY) / cell);
+
+        int best = -1;
+        double bestDist = 0;
+        for (int y = std::max(0, cy - reach); y <= std::min(gridH - 1, cy + reach); y++) {
+            for (int x = std::max(0, cx - reach); x <= std::min(gridW - 1, cx + reach); x++) {
+                for (int i = head[y * gridW + x]; i >= 0; i = next[i]) {
+                    double dist = cv::norm(p - level->centers[i]);
+                    if (dist > maxDist) continue;
+                    if (best < 0 || dist < bestDist || (dist == bestDist && i < best)) {
+                        best = i;
+                        bestDist = dist;
+                    }
+                }
+            }
+        }
+        if (distance && best >= 0) *distance = bestDist;
+        return best;
+    }
+
+private:
+    const LevelContours* level;
+    float cell, minX, minY;
+    int gridW, gridH;
+    std::vector<int> head, next;
+
+    int cellOf(const cv::Point2f& p) const {
+        int x = std::min(gridW - 1, (int)((p.x - minX) / cell));
+        int y = std::min(gridH - 1, (int)((p.y - minY) / cell));
+        return y * gridW + x;
+    }
+};
+
+// Group blob centers found at successive threshold levels: each center (in
+// level order) joins the oldest group holding a center closer than `radius`,
+// or starts a new group. Grouped centers are kept in a uniform grid of
+// radius-sized cells (per-cell linked lists over the bounding box), so a
+// lookup only visits the 3x3 cells around the center: amortized O(1)
+// instead of a scan over every grouped point. The result is the same as the
+// exhaustive scan.
+inline void groupBlobCenters(const std::vector<std::vector<cv::Point2f> >& centers, float radius,
+                             std::vector<std::vector<cv::Point2f> >& groups) {
+    groups.clear();
+
+    size_t total = 0;
+    float minX = 0, minY = 0, maxX = 0, maxY = 0;
+    for (size_t l = 0; l < centers.size(); l++) {
+        for (size_t i = 0; i < centers[l].size(); i++) {
+            const cv::Point2f& p = centers[l][i];
+            if (total++ == 0) { minX = maxX = p.x; minY = maxY = p.y; continue; }
+            minX = std::min(minX, p.x); maxX = std::max(maxX, p.x);
+            minY = std::min(minY, p.y); maxY = std::max(maxY, p.y);
+        }
+    }
+    if (total == 0) return;
+
+    const int gridW = (int)((maxX - minX) / radius) + 1, gridH = (int)((maxY - minY) / radius) + 1;
+    std::vector<int> head((size_t)gridW * gridH, -1), next, groupOf;
+    std::vector<cv::Point2f> points;
+    next.reserve(total); groupOf.reserve(total); points.reserve(total);
+
+    for (size_t l = 0; l < centers.size(); l++) {
+        for (size_t i = 0; i < centers[l].size(); i++) {
+            const cv::Point2f& center = centers[l][i];
+            int cx = std::min(gridW - 1, (int)((center.x - minX) / radius));
+            int cy = std::min(gridH - 1, (int)((center.y - minY) / radius));
+
+            // Oldest group with a point in range
+            int best = -1;
+            for (int y = std::max(0, cy - 1); y <= std::min(gridH - 1, cy + 1); y++) {
+                for (int x = std::max(0, cx - 1); x <= std::min(gridW - 1, cx + 1); x++) {
+                    for (int j = head[y * gridW + x]; j >= 0; j = next[j]) {
+                        if (best >= 0 && groupOf[j] >= best) continue;
+                        float dist = (float)cv::norm(center - points[j]);
+                        if (dist < radius) best = groupOf[j];
+                    }
+                }
+            }
+            if (best < 0) {
+                best = (int)groups.size();
+                groups.push_back(std::vector<cv::Point2f>());
+            }
+            groups[best].push_back(center);
+
+            int index = (int)points.size();
+            points.push_back(center);
+            groupOf.push_back(best);
+            next.push_back(head[cy * gridW + cx]);
+            head[cy * gridW + cx] = index;
+        }
+    }
+}
+
+#endif // BLOB_CORE_HPP
@@ -7,104 +7,175 @@
 #include <string>
 #include <vector>
 
+#include "dog_detector.hpp"
+#include "fast_hessian.hpp"
+#include "harris_core.hpp"
+#include "harris_fixed.hpp"
+#include "harris_sparse.hpp"
+#include "harris_stream.hpp"
+#include "image_pyramid.hpp"
+#include "keypoint_select.hpp"
+#include "lbp_descriptor.hpp"
+#include "pair_extract.hpp"
+
 using namespace cv;
 using namespace cv::xfeatures2d;
 using namespace std;
 
+// Keypoints per image for the Harris, DoG and blob paths (grid bucketing + ANMS)
+const int KEYPOINT_BUDGET = 500;
+
+// "harris_fixed" detector: fixed-point Harris path (harris_fixed.hpp)
+bool harrisFixedPoint = false;
+// "harris_sparse" detector: coarse-to-fine Harris (harris_sparse.hpp)
+bool harrisSparse = false;
+// "hessian" detector in m commands: Fast-Hessian blobs (fast_hessian.hpp) in the blob paths
+bool blobHessian = false;
+const double HESSIAN_THRESHOLD = 100;
+// "dog_native" detector: in-project DoG detector (dog_detector.hpp) in the DoG paths
+bool dogNative = false;
+// "lbp_integral" descriptor: 59-bin uniform LBP from the integral histogram (lbp_descriptor.hpp);
+// either LBP name takes an optional ":<patch size>" suffix, e.g. lbp_integral:96
+bool lbpIntegral = false;
+int lbpPatchSize = LBP_PATCH_SIZE;
+
 // Function prototypes
 void detectHarrisAuto(const string& imagePath, const string& outputPath);
+void detectHarrisStreamAuto(const string& imagePath, const string& outputPath);
 void detectBlobAuto(const string& imagePath, const string& outputPath);
 void detectDoGAuto(const string& imagePath, const string& outputPath);
+void detectHessianAuto(const string& imagePath, const string& outputPath);
 void matchHarrisSIFTAuto(const string& img1Path, const string& img2Path, const string& outputPath);
 void matchDoGSIFTAuto(const string& img1Path, const string& img2Path, const string& outputPath);
 void matchBlobSIFTAuto(const string& img1Path, const string& img2Path, const string& outputPath);
 void matchHarrisLBPAuto(const string& img1Path, const string& img2Path, const string& outputPath);
 void matchDoGLBPAuto(const string& img1Path, const string& img2Path, const string& outputPath);
 void matchBlobLBPAuto(const string& img1Path, const string& img2Path, const string& outputPath);
+void detectAllAuto(const string& imagePath, const string& outputPrefix);
+void matchAllAuto(const string& img1Path, const string& img2Path, const string& outputPrefix);
 
-// Shared LBP computation
-Mat computeLBPDescriptor(const Mat& gray, Point2f center) {
-    int patchSize = 40;
-    int x = cvRound(center.x), y = cvRound(center.y);
-    int x1 = max(0, x - patchSize/2), y1 = max(0, y - patchSize/2);
-    int x2 = min(gray.cols, x + patchSize/2), y2 = min(gray.rows, y + patchSize/2);
-    if (x2 <= x1 + 5 || y2 <= y1 + 5) return Mat();
-    
-    Mat patch = gray(Rect(x1, y1, x2-x1, y2-y1));
-    Mat lbp = Mat::zeros(patch.size(), CV_8U);
-    
-    for (int i = 1; i < patch.rows - 1; i++) {
-        for (int j = 1; j < patch.cols - 1; j++) {
-            uchar c = patch.at<uchar>(i, j), code = 0;
-            code |= (patch.at<uchar>(i-1,j) >= c) << 7;
-            code |= (patch.at<uchar>(i-1,j+1) >= c) << 6;
-            code |= (patch.at<uchar>(i,j+1) >= c) << 5;
-            code |= (patch.at<uchar>(i+1,j+1) >= c) << 4;
-            code |= (patch.at<uchar>(i+1,j) >= c) << 3;
-            code |= (patch.at<uchar>(i+1,j-1) >= c) << 2;
-            code |= (patch.at<uchar>(i,j-1) >= c) << 1;
-            code |= (patch.at<uchar>(i-1,j-1) >= c) << 0;
-            lbp.at<uchar>(i,j) = code;
-        }
+// Images read by this run, with their pyramids (image_pyramid.hpp). The "all"
+// commands run several detectors or combinations on the same images, which
+// are then read, converted and have their levels built only once.
+struct LoadedImage {
+    Mat color;
+    ImagePyramid pyramid;
+    LoadedImage(const Mat& colorImage, const Mat& gray) : color(colorImage), pyramid(gray) {}
+};
+map<string, Ptr<LoadedImage>> loadedImages;
+
+LoadedImage* loadImage(const string& path) {
+    Ptr<LoadedImage>& entry = loadedImages[path];
+    if (!entry) {
+        Mat img = imread(path);
+        if (img.empty()) return 0;
+        Mat gray; cvtColor(img, gray, COLOR_BGR2GRAY);
+        entry = makePtr<LoadedImage>(img, gray);
     }
-    
-    int histSize = 256;
-    float range[] = {0, 256};
-    const float* histRange = {range};
-    Mat hist;
-    calcHist(&lbp, 1, 0, Mat(), hist, 1, &histSize, &histRange);
-    hist += 1e-7;
-    hist /= cv::sum(hist)[0];
-    return hist.reshape(1, 1);
+    return entry.get();
+}
+
+// Coarse-to-fine Harris, same parameters and selection as detectHarrisKeypoints;
+// the coarse stage runs on the pyramid's cached level 1
+vector<KeyPoint> detectHarrisKeypointsSparse(ImagePyramid& pyramid) {
+    const Mat& gray = pyramid.gray();
+    HarrisSparseResult sparse;
+    computeHarrisSparse(gray, sparse, 1, 3, 0.04, 120, 64, pyramid.level(1));
+    vector<KeyPoint> kps;
+    float cutoff = normalizedThreshold(sparse.minResponse, sparse.maxResponse, 200);
+    selectKeypointsNMS(sparse.response, cutoff, 1, 4 * KEYPOINT_BUDGET, kps);
+    distributeKeypoints(kps, gray.size(), KEYPOINT_BUDGET);
+    return kps;
+}
+
+// Blob keypoints (SimpleBlobDetector or Fast-Hessian), evenly spread; one detector per call
+vector<KeyPoint> detectBlobKeypoints(ImagePyramid& pyramid, const SimpleBlobDetector::Params& params) {
+    const Mat& gray = pyramid.gray();
+    vector<KeyPoint> kps;
+    if (blobHessian) detectFastHessian(gray, kps, HESSIAN_THRESHOLD);
+    else SimpleBlobDetector::create(params)->detect(gray, kps);
+    distributeKeypoints(kps, gray.size(), KEYPOINT_BUDGET);
+    return kps;
+}
+
+// DoG keypoints (SIFT::detect, or the in-project detector on the pyramid's
+// cached scale space), not spread; one detector per call
+vector<KeyPoint> detectDoGKeypoints(ImagePyramid& pyramid) {
+    vector<KeyPoint> kps;
+    if (dogNative) detectDoGInPyramid(pyramid.dog(), kps);
+    else SIFT::create()->detect(pyramid.gray(), kps);
+    return kps;
+}
+
+// LBP descriptors for the current mode, from the pyramid's cached code image or integral histogram
+void describeLBP(ImagePyramid& pyramid, const vector<KeyPoint>& kp, Mat& d) {
+    if (lbpIntegral) computeLBPDescriptors(pyramid.lbpIntegral(lbpPatchSize), kp, d, lbpPatchSize);
+    else computeLBPDescriptors(pyramid.lbpCodes(), kp, d, lbpPatchSize);
+}
+
+void reportLBPIntegral(ImagePyramid& pyramid1, ImagePyramid& pyramid2) {
+    if (!lbpIntegral) return;
+    size_t bytes = pyramid1.lbpIntegralBytes() + pyramid2.lbpIntegralBytes();
+    cout << "LBP integral histograms: " << bytes / (1024 * 1024) << " MB (both images, "
+         << LBP_UNIFORM_BINS << " bins, patch " << lbpPatchSize << ")" << endl;
 }
 
 // Manual Harris detection
-vector<KeyPoint> detectHarrisKeypoints(const Mat& gray) {
-    int blockSize = 2, apertureSize = 3;
+vector<KeyPoint> detectHarrisKeypoints(ImagePyramid& pyramid) {
+    if (harrisSparse) return detectHarrisKeypointsSparse(pyramid);
+    const Mat& gray = pyramid.gray();
+    int blockSize = 1, apertureSize = 3; // 3x3 Gaussian window
     double k = 0.04;
-    Mat Ix, Iy;
-    Sobel(gray, Ix, CV_32F, 1, 0, apertureSize);
-    Sobel(gray, Iy, CV_32F, 0, 1, apertureSize);
-    Mat Ixx, Iyy, Ixy;
-    multiply(Ix, Ix, Ixx); multiply(Iy, Iy, Iyy); multiply(Ix, Iy, Ixy);
-    Mat Sxx, Syy, Sxy;
-    GaussianBlur(Ixx, Sxx, Size(3,3), 0); GaussianBlur(Iyy, Syy, Size(3,3), 0); GaussianBlur(Ixy, Sxy, Size(3,3), 0);
-    Mat harris(gray.size(), CV_32F);
-    for(int i=0; i<gray.rows; i++) {
-        for(int j=0; j<gray.cols; j++) {
-            float sxx = Sxx.at<float>(i,j), syy = Syy.at<float>(i,j), sxy = Sxy.at<float>(i,j);
-            harris.at<float>(i,j) = sxx*syy - sxy*sxy - k*(sxx+syy)*(sxx+syy);
-        }
-    }
-    Mat harrisNorm, mask;
-    normalize(harris, harrisNorm, 0, 255, NORM_MINMAX);
-    threshold(harrisNorm, mask, 200, 255, THRESH_BINARY);
-    mask.convertTo(mask, CV_8U);
-    vector<Point> corners;
-    findNonZero(mask, corners);
+    Mat harris;
+    if (!(harrisFixedPoint && computeHarrisFixed(gray, harris, blockSize, apertureSize, k)))
+        computeHarrisTiled(gray, harris, blockSize, apertureSize, k);
+    // 3x3 local maxima above 200 on the normalized scale, evenly spread
     vector<KeyPoint> kps;
-    for(size_t i=0; i<min((size_t)500, corners.size()); i++) kps.push_back(KeyPoint(corners[i].x, corners[i].y, 1));
+    selectKeypointsNMS(harris, normalizedThreshold(harris, 200), 1, 4 * KEYPOINT_BUDGET, kps);
+    distributeKeypoints(kps, gray.size(), KEYPOINT_BUDGET);
     return kps;
 }
 
 int main(int argc, char** argv) {
     if (argc < 4) {
         cerr << "Usage: ./cvlab_auto <command> <input> [input2] <output>" << endl;
+        cerr << "       ./cvlab_auto all <image> <prefix> | m all <img1> <img2> <prefix>" << endl;
         return -1;
     }
     
     string command = argv[1];
+    if (command == "harris_fixed") { harrisFixedPoint = true; command = "harris"; }
+    else if (command == "harris_sparse") { harrisSparse = true; command = "harris"; }
+    else if (command == "dog_native") { dogNative = true; command = "dog"; }
     
-    if (command == "harris") detectHarrisAuto(argv[2], argv[3]);
+    if (command == "all") detectAllAuto(argv[2], argv[3]);
+    else if (command == "harris") detectHarrisAuto(argv[2], argv[3]);
+    else if (command == "harris_stream") detectHarrisStreamAuto(argv[2], argv[3]);
     else if (command == "blob") detectBlobAuto(argv[2], argv[3]);
     else if (command == "dog") detectDoGAuto(argv[2], argv[3]);
+    else if (command == "hessian") detectHessianAuto(argv[2], argv[3]);
     else if (command == "m") {
         if (argc < 6) return -1;
         string detector = argv[2];
+        if (detector == "all") {  // m all <img1> <img2> <prefix>
+            matchAllAuto(argv[3], argv[4], argv[5]);
+            return 0;
+        }
+        if (argc < 7) return -1;
         string descriptor = argv[3];
         string img1 = argv[4];
         string img2 = argv[5];
         string out = argv[6];
+        if (detector == "harris_fixed") { harrisFixedPoint = true; detector = "harris"; }
+        else if (detector == "harris_sparse") { harrisSparse = true; detector = "harris"; }
+        else if (detector == "hessian") { blobHessian = true; detector = "blob"; }
+        else if (detector == "dog_native") { dogNative = true; detector = "dog"; }
+        size_t colon = descriptor.find(':');
+        if (colon != string::npos) {
+            lbpPatchSize = max(6, atoi(descriptor.c_str() + colon + 1));
+            descriptor = descriptor.substr(0, colon);
+        }
+        if (descriptor == "lbp_integral") { lbpIntegral = true; descriptor = "lbp"; }
         
         if (detector == "harris" && descriptor == "sift") matchHarrisSIFTAuto(img1, img2, out);
         else if (detector == "dog" && descriptor == "sift") matchDoGSIFTAuto(img1, img2, out);
@@ -117,10 +188,10 @@ int main(int argc, char** argv) {
 }
 
 void detectHarrisAuto(const string& imagePath, const string& outputPath) {
-    Mat img = imread(imagePath);
-    if(img.empty()) return;
-    Mat gray; cvtColor(img, gray, COLOR_BGR2GRAY);
-    vector<KeyPoint> kps = detectHarrisKeypoints(gray);
+    LoadedImage* in = loadImage(imagePath);
+    if(!in) return;
+    const Mat& img = in->color;
+    vector<KeyPoint> kps = detectHarrisKeypoints(in->pyramid);
     Mat res = img.clone();
     for(auto& kp : kps) circle(res, kp.pt, 3, Scalar(0,0,255), 2);
     putText(res, "Harris: " + to_string(kps.size()), Point(10,30), FONT_HERSHEY_SIMPLEX, 0.7, Scalar(0,255,0), 2);
@@ -128,10 +199,31 @@ void detectHarrisAuto(const string& imagePath, const string& outputPath) {
     cout << "Saved: " << outputPath << endl;
 }
 
+// Bounded-memory Harris for very large images: rows are streamed through
+// line buffers instead of allocating full-size float planes.
+void detectHarrisStreamAuto(const string& imagePath, const string& outputPath) {
+    LoadedImage* in = loadImage(imagePath);
+    if(!in) return;
+    const Mat& img = in->color;
+    const Mat& gray = in->pyramid.gray();
+    HarrisStream stream(gray.cols, gray.rows, 1, 3, 0.04); // same parameters as detectHarrisKeypoints
+    stream.pushImage(gray);
+    vector<HarrisCandidate> corners = stream.corners(200);
+    Mat res = img.clone();
+    for(auto& c : corners) circle(res, c.pt, 3, Scalar(0,0,255), 2);
+    putText(res, "Harris (stream): " + to_string(corners.size()), Point(10,30), FONT_HERSHEY_SIMPLEX, 0.7, Scalar(0,255,0), 2);
+    imwrite(outputPath, res);
+    double fullFrameMB = 10.0 * sizeof(float) * gray.total() / (1024.0 * 1024.0);
+    cout << "Line buffers: " << stream.bufferBytes() / 1024 << " KB (full-frame pipeline: ~"
+         << cvRound(fullFrameMB) << " MB)" << endl;
+    cout << "Saved: " << outputPath << endl;
+}
+
 void detectBlobAuto(const string& imagePath, const string& outputPath) {
-    Mat img = imread(imagePath);
-    if(img.empty()) return;
-    Mat gray; cvtColor(img, gray, COLOR_BGR2GRAY);
+    LoadedImage* in = loadImage(imagePath);
+    if(!in) return;
+    const Mat& img = in->color;
+    const Mat& gray = in->pyramid.gray();
     SimpleBlobDetector::Params params;
     params.minThreshold = 10; params.maxThreshold = 220;
     params.filterByArea = true; params.minArea = 100;
@@ -140,6 +232,7 @@ void detectBlobAuto(const string& imagePath, const string& outputPath) {
     params.filterByInertia = true; params.minInertiaRatio = 0.1f;
     Ptr<SimpleBlobDetector> detector = SimpleBlobDetector::create(params);
     vector<KeyPoint> kps; detector->detect(gray, kps);
+    distributeKeypoints(kps, gray.size(), KEYPOINT_BUDGET);
     Mat res; drawKeypoints(img, kps, res, Scalar(0,0,255), DrawMatchesFlags::DRAW_RICH_KEYPOINTS);
     putText(res, "Blobs: " + to_string(kps.size()), Point(10,30), FONT_HERSHEY_SIMPLEX, 0.7, Scalar(0,255,0), 2);
     imwrite(outputPath, res);
@@ -147,24 +240,50 @@ void detectBlobAuto(const string& imagePath, const string& outputPath) {
 }
 
 void detectDoGAuto(const string& imagePath, const string& outputPath) {
-    Mat img = imread(imagePath);
-    if(img.empty()) return;
-    Mat gray; cvtColor(img, gray, COLOR_BGR2GRAY);
-    Ptr<SIFT> sift = SIFT::create(500);
-    vector<KeyPoint> kps; sift->detect(gray, kps);
+    LoadedImage* in = loadImage(imagePath);
+    if(!in) return;
+    const Mat& img = in->color;
+    const Mat& gray = in->pyramid.gray();
+    int64 start = getTickCount();
+    vector<KeyPoint> kps = detectDoGKeypoints(in->pyramid);
+    double ms = (getTickCount() - start) * 1000.0 / getTickFrequency();
+    distributeKeypoints(kps, gray.size(), KEYPOINT_BUDGET);
     Mat res; drawKeypoints(img, kps, res, Scalar(0,0,255), DrawMatchesFlags::DRAW_RICH_KEYPOINTS);
     putText(res, "DoG: " + to_string(kps.size()), Point(10,30), FONT_HERSHEY_SIMPLEX, 0.7, Scalar(0,255,0), 2);
     imwrite(outputPath, res);
+    cout << "Detection: " << ms << " ms" << endl;
+    cout << "Saved: " << outputPath << endl;
+}
+
+void detectHessianAuto(const string& imagePath, const string& outputPath) {
+    LoadedImage* in = loadImage(imagePath);
+    if(!in) return;
+    const Mat& img = in->color;
+    const Mat& gray = in->pyramid.gray();
+    int64 start = getTickCount();
+    vector<KeyPoint> kps; detectFastHessian(gray, kps, HESSIAN_THRESHOLD);
+    double ms = (getTickCount() - start) * 1000.0 / getTickFrequency();
+    distributeKeypoints(kps, gray.size(), KEYPOINT_BUDGET);
+    Mat res; drawKeypoints(img, kps, res, Scalar(0,0,255), DrawMatchesFlags::DRAW_RICH_KEYPOINTS);
+    putText(res, "Hessian: " + to_string(kps.size()), Point(10,30), FONT_HERSHEY_SIMPLEX, 0.7, Scalar(0,255,0), 2);
+    imwrite(outputPath, res);
+    cout << "Detection: " << ms << " ms" << endl;
     cout << "Saved: " << outputPath << endl;
 }
 
 void matchHarrisSIFTAuto(const string& img1Path, const string& img2Path, const string& outputPath) {
-    Mat img1 = imread(img1Path), img2 = imread(img2Path);
-    if(img1.empty() || img2.empty()) return;
-    Mat gray1, gray2; cvtColor(img1, gray1, COLOR_BGR2GRAY); cvtColor(img2, gray2, COLOR_BGR2GRAY);
-    vector<KeyPoint> kp1 = detectHarrisKeypoints(gray1), kp2 = detectHarrisKeypoints(gray2);
-    Ptr<SIFT> sift = SIFT::create();
-    Mat d1, d2; sift->compute(gray1, kp1, d1); sift->compute(gray2, kp2, d2);
+    LoadedImage* in1 = loadImage(img1Path);
+    LoadedImage* in2 = loadImage(img2Path);
+    if(!in1 || !in2) return;
+    const Mat& img1 = in1->color;
+    const Mat& img2 = in2->color;
+    vector<KeyPoint> kp1, kp2; Mat d1, d2;
+    double ms = extractPair(in1->pyramid, in2->pyramid, kp1, kp2, d1, d2, [](ImagePyramid& pyramid, vector<KeyPoint>& kp, Mat& d) {
+        const Mat& gray = pyramid.gray();
+        kp = detectHarrisKeypoints(pyramid);
+        SIFT::create()->compute(gray, kp, d);
+    });
+    cout << "Extraction (both images): " << ms << " ms" << endl;
     BFMatcher matcher(NORM_L2);
     vector<vector<DMatch>> knn; matcher.knnMatch(d1, d2, knn, 2);
     vector<DMatch> good;
@@ -176,12 +295,18 @@ void matchHarrisSIFTAuto(const string& img1Path, const string& img2Path, const s
 }
 
 void matchDoGSIFTAuto(const string& img1Path, const string& img2Path, const string& outputPath) {
-    Mat img1 = imread(img1Path), img2 = imread(img2Path);
-    if(img1.empty() || img2.empty()) return;
-    Mat gray1, gray2; cvtColor(img1, gray1, COLOR_BGR2GRAY); cvtColor(img2, gray2, COLOR_BGR2GRAY);
-    Ptr<SIFT> sift = SIFT::create();
+    LoadedImage* in1 = loadImage(img1Path);
+    LoadedImage* in2 = loadImage(img2Path);
+    if(!in1 || !in2) return;
+    const Mat& img1 = in1->color;
+    const Mat& img2 = in2->color;
     vector<KeyPoint> kp1, kp2; Mat d1, d2;
-    sift->detectAndCompute(gray1, Mat(), kp1, d1); sift->detectAndCompute(gray2, Mat(), kp2, d2);
+    double ms = extractPair(in1->pyramid, in2->pyramid, kp1, kp2, d1, d2, [](ImagePyramid& pyramid, vector<KeyPoint>& kp, Mat& d) {
+        const Mat& gray = pyramid.gray();
+        if (dogNative) { kp = detectDoGKeypoints(pyramid); SIFT::create()->compute(gray, kp, d); }
+        else SIFT::create()->detectAndCompute(gray, Mat(), kp, d);
+    });
+    cout << "Extraction (both images): " << ms << " ms" << endl;
     BFMatcher matcher(NORM_L2);
     vector<vector<DMatch>> knn; matcher.knnMatch(d1, d2, knn, 2);
     vector<DMatch> good;
@@ -193,18 +318,23 @@ void matchDoGSIFTAuto(const string& img1Path, const string& img2Path, const stri
 }
 
 void matchBlobSIFTAuto(const string& img1Path, const string& img2Path, const string& outputPath) {
-    Mat img1 = imread(img1Path), img2 = imread(img2Path);
-    if(img1.empty() || img2.empty()) return;
-    Mat gray1, gray2; cvtColor(img1, gray1, COLOR_BGR2GRAY); cvtColor(img2, gray2, COLOR_BGR2GRAY);
+    LoadedImage* in1 = loadImage(img1Path);
+    LoadedImage* in2 = loadImage(img2Path);
+    if(!in1 || !in2) return;
+    const Mat& img1 = in1->color;
+    const Mat& img2 = in2->color;
     SimpleBlobDetector::Params params;
     params.minThreshold = 10; params.maxThreshold = 220;
     params.filterByArea = true; params.minArea = 100;
     params.filterByCircularity = true; params.minCircularity = 0.04f;
     params.filterByConvexity = true; params.minConvexity = 0.58f;
-    Ptr<SimpleBlobDetector> detector = SimpleBlobDetector::create(params);
-    vector<KeyPoint> kp1, kp2; detector->detect(gray1, kp1); detector->detect(gray2, kp2);
-    Ptr<SIFT> sift = SIFT::create();
-    Mat d1, d2; sift->compute(gray1, kp1, d1); sift->compute(gray2, kp2, d2);
+    vector<KeyPoint> kp1, kp2; Mat d1, d2;
+    double ms = extractPair(in1->pyramid, in2->pyramid, kp1, kp2, d1, d2, [&](ImagePyramid& pyramid, vector<KeyPoint>& kp, Mat& d) {
+        const Mat& gray = pyramid.gray();
+        kp = detectBlobKeypoints(pyramid, params);
+        SIFT::create()->compute(gray, kp, d);
+    });
+    cout << "Extraction (both images): " << ms << " ms" << endl;
     BFMatcher matcher(NORM_L2);
     vector<vector<DMatch>> knn; matcher.knnMatch(d1, d2, knn, 2);
     vector<DMatch> good;
@@ -216,13 +346,18 @@ void matchBlobSIFTAuto(const string& img1Path, const string& img2Path, const str
 }
 
 void matchHarrisLBPAuto(const string& img1Path, const string& img2Path, const string& outputPath) {
-    Mat img1 = imread(img1Path), img2 = imread(img2Path);
-    if(img1.empty() || img2.empty()) return;
-    Mat gray1, gray2; cvtColor(img1, gray1, COLOR_BGR2GRAY); cvtColor(img2, gray2, COLOR_BGR2GRAY);
-    vector<KeyPoint> kp1 = detectHarrisKeypoints(gray1), kp2 = detectHarrisKeypoints(gray2);
-    Mat d1(kp1.size(), 256, CV_32F), d2(kp2.size(), 256, CV_32F);
-    for(size_t i=0; i<kp1.size(); i++) computeLBPDescriptor(gray1, kp1[i].pt).copyTo(d1.row(i));
-    for(size_t i=0; i<kp2.size(); i++) computeLBPDescriptor(gray2, kp2[i].pt).copyTo(d2.row(i));
+    LoadedImage* in1 = loadImage(img1Path);
+    LoadedImage* in2 = loadImage(img2Path);
+    if(!in1 || !in2) return;
+    const Mat& img1 = in1->color;
+    const Mat& img2 = in2->color;
+    vector<KeyPoint> kp1, kp2; Mat d1, d2;
+    double ms = extractPair(in1->pyramid, in2->pyramid, kp1, kp2, d1, d2, [](ImagePyramid& pyramid, vector<KeyPoint>& kp, Mat& d) {
+        kp = detectHarrisKeypoints(pyramid);
+        describeLBP(pyramid, kp, d);
+    });
+    cout << "Extraction (both images): " << ms << " ms" << endl;
+    reportLBPIntegral(in1->pyramid, in2->pyramid);
     vector<DMatch> good;
     for(size_t i=0; i<kp1.size(); i++) {
         double best=1e9, second=1e9; int idx=-1;
@@ -240,14 +375,20 @@ void matchHarrisLBPAuto(const string& img1Path, const string& img2Path, const st
 }
 
 void matchDoGLBPAuto(const string& img1Path, const string& img2Path, const string& outputPath) {
-    Mat img1 = imread(img1Path), img2 = imread(img2Path);
-    if(img1.empty() || img2.empty()) return;
-    Mat gray1, gray2; cvtColor(img1, gray1, COLOR_BGR2GRAY); cvtColor(img2, gray2, COLOR_BGR2GRAY);
-    Ptr<SIFT> sift = SIFT::create(500);
-    vector<KeyPoint> kp1, kp2; sift->detect(gray1, kp1); sift->detect(gray2, kp2);
-    Mat d1(kp1.size(), 256, CV_32F), d2(kp2.size(), 256, CV_32F);
-    for(size_t i=0; i<kp1.size(); i++) computeLBPDescriptor(gray1, kp1[i].pt).copyTo(d1.row(i));
-    for(size_t i=0; i<kp2.size(); i++) computeLBPDescriptor(gray2, kp2[i].pt).copyTo(d2.row(i));
+    LoadedImage* in1 = loadImage(img1Path);
+    LoadedImage* in2 = loadImage(img2Path);
+    if(!in1 || !in2) return;
+    const Mat& img1 = in1->color;
+    const Mat& img2 = in2->color;
+    vector<KeyPoint> kp1, kp2; Mat d1, d2;
+    double ms = extractPair(in1->pyramid, in2->pyramid, kp1, kp2, d1, d2, [](ImagePyramid& pyramid, vector<KeyPoint>& kp, Mat& d) {
+        const Mat& gray = pyramid.gray();
+        kp = detectDoGKeypoints(pyramid);
+        distributeKeypoints(kp, gray.size(), KEYPOINT_BUDGET);
+        describeLBP(pyramid, kp, d);
+    });
+    cout << "Extraction (both images): " << ms << " ms" << endl;
+    reportLBPIntegral(in1->pyramid, in2->pyramid);
     vector<DMatch> good;
     for(size_t i=0; i<kp1.size(); i++) {
         double best=1e9, second=1e9; int idx=-1;
@@ -265,19 +406,23 @@ void matchDoGLBPAuto(const string& img1Path, const string& img2Path, const strin
 }
 
 void matchBlobLBPAuto(const string& img1Path, const string& img2Path, const string& outputPath) {
-    Mat img1 = imread(img1Path), img2 = imread(img2Path);
-    if(img1.empty() || img2.empty()) return;
-    Mat gray1, gray2; cvtColor(img1, gray1, COLOR_BGR2GRAY); cvtColor(img2, gray2, COLOR_BGR2GRAY);
+    LoadedImage* in1 = loadImage(img1Path);
+    LoadedImage* in2 = loadImage(img2Path);
+    if(!in1 || !in2) return;
+    const Mat& img1 = in1->color;
+    const Mat& img2 = in2->color;
     SimpleBlobDetector::Params params;
     params.minThreshold = 10; params.maxThreshold = 220;
     params.filterByArea = true; params.minArea = 100;
     params.filterByCircularity = true; params.minCircularity = 0.04f;
     params.filterByConvexity = true; params.minConvexity = 0.58f;
-    Ptr<SimpleBlobDetector> detector = SimpleBlobDetector::create(params);
-    vector<KeyPoint> kp1, kp2; detector->detect(gray1, kp1); detector->detect(gray2, kp2);
-    Mat d1(kp1.size(), 256, CV_32F), d2(kp2.size(), 256, CV_32F);
-    for(size_t i=0; i<kp1.size(); i++) computeLBPDescriptor(gray1, kp1[i].pt).copyTo(d1.row(i));
-    for(size_t i=0; i<kp2.size(); i++) computeLBPDescriptor(gray2, kp2[i].pt).copyTo(d2.row(i));
+    vector<KeyPoint> kp1, kp2; Mat d1, d2;
+    double ms = extractPair(in1->pyramid, in2->pyramid, kp1, kp2, d1, d2, [&](ImagePyramid& pyramid, vector<KeyPoint>& kp, Mat& d) {
+        kp = detectBlobKeypoints(pyramid, params);
+        describeLBP(pyramid, kp, d);
+    });
+    cout << "Extraction (both images): " << ms << " ms" << endl;
+    reportLBPIntegral(in1->pyramid, in2->pyramid);
     vector<DMatch> good;
     for(size_t i=0; i<kp1.size(); i++) {
         double best=1e9, second=1e9; int idx=-1;
@@ -293,3 +438,46 @@ void matchBlobLBPAuto(const string& img1Path, const string& img2Path, const stri
     imwrite(outputPath, res);
     cout << "Saved: " << outputPath << endl;
 }
+
+// Every detector on one image: <prefix>_harris.jpg, ... The pyramid-backed
+// variants (harris_sparse, dog_native) run too; the default Harris, blob and
+// SIFT paths work on the full image and take nothing from the pyramid.
+void detectAllAuto(const string& imagePath, const string& outputPrefix) {
+    detectHarrisAuto(imagePath, outputPrefix + "_harris.jpg");
+    detectBlobAuto(imagePath, outputPrefix + "_blob.jpg");
+    detectDoGAuto(imagePath, outputPrefix + "_dog.jpg");
+    detectHessianAuto(imagePath, outputPrefix + "_hessian.jpg");
+
+    bool sparse = harrisSparse, native = dogNative;
+    harrisSparse = dogNative = true;
+    detectHarrisAuto(imagePath, outputPrefix + "_harris_sparse.jpg");
+    detectDoGAuto(imagePath, outputPrefix + "_dog_native.jpg");
+    harrisSparse = sparse; dogNative = native;
+
+    LoadedImage* in = loadImage(imagePath);
+    if(in) cout << "Pyramid products: " << in->pyramid.describe() << endl;
+}
+
+// Every detector/descriptor combination on one pair: <prefix>_harris_sift.jpg, ...
+// plus the harris_sparse and dog_native variants, whose SIFT and LBP runs
+// share the pyramid level and DoG scale space of each image.
+void matchAllAuto(const string& img1Path, const string& img2Path, const string& outputPrefix) {
+    matchHarrisSIFTAuto(img1Path, img2Path, outputPrefix + "_harris_sift.jpg");
+    matchDoGSIFTAuto(img1Path, img2Path, outputPrefix + "_dog_sift.jpg");
+    matchBlobSIFTAuto(img1Path, img2Path, outputPrefix + "_blob_sift.jpg");
+    matchHarrisLBPAuto(img1Path, img2Path, outputPrefix + "_harris_lbp.jpg");
+    matchDoGLBPAuto(img1Path, img2Path, outputPrefix + "_dog_lbp.jpg");
+    matchBlobLBPAuto(img1Path, img2Path, outputPrefix + "_blob_lbp.jpg");
+
+    bool sparse = harrisSparse, native = dogNative;
+    harrisSparse = dogNative = true;
+    matchHarrisSIFTAuto(img1Path, img2Path, outputPrefix + "_harris_sparse_sift.jpg");
+    matchHarrisLBPAuto(img1Path, img2Path, outputPrefix + "_harris_sparse_lbp.jpg");
+    matchDoGSIFTAuto(img1Path, img2Path, outputPrefix + "_dog_native_sift.jpg");
+    matchDoGLBPAuto(img1Path, img2Path, outputPrefix + "_dog_native_lbp.jpg");
+    harrisSparse = sparse; dogNative = native;
+
+    LoadedImage* in1 = loadImage(img1Path);
+    LoadedImage* in2 = loadImage(img2Path);
+    if(in1 && in2) cout << "Pyramid products: " << in1->pyramid.describe() << " / " << in2->pyramid.describe() << endl;
+}
@@ -0,0 +1,360 @@
+#ifndef DOG_DETECTOR_HPP
+#define DOG_DETECTOR_HPP
+
+#include <opencv2/core.hpp>
+#include <opencv2/core/hal/intrin.hpp>
+#include <opencv2/features2d.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <vector>
+
+// In-project DoG (SIFT) keypoint detector ("dog_native" in cvlab/cvlab_auto).
+//
+// Follows SIFT::detect step for step (doubled input, nOctaveLayers + 3
+// Gaussian images per octave, 3x3x3 DoG extrema, quadratic refinement,
+// contrast and edge tests, orientation histogram) and packs
+// KeyPoint::octave the same way, so SIFT::compute accepts the keypoints.
+// The work is laid out for the thread pool instead of one thread:
+//  - every Gaussian image is blurred straight from its octave's base, so only
+//    the octave bases form a chain and all other layers are independent tasks
+//  - the extrema scan is one task per (octave, layer), with a SIMD pre-pass
+//    that skips samples under the contrast pre-threshold
+// Detection is split into buildDoGPyramid / findDoGCandidates /
+// filterDoGCandidates so callers can keep the pyramid or the candidates
+// across threshold changes.
+
+struct DoGPyramid {
+    int nOctaves, nOctaveLayers, firstOctave;  // firstOctave -1: octave 0 is the doubled image
+    double sigma;
+    std::vector<cv::Mat> gauss;  // CV_32F on the 0..255 scale, [o * (nOctaveLayers + 3) + i]
+    std::vector<cv::Mat> dog;    // CV_32F, gauss[i + 1] - gauss[i], [o * (nOctaveLayers + 2) + i]
+};
+
+// One refined extremum at one dominant orientation
+struct DoGCandidate {
+    cv::KeyPoint keypoint;  // as SIFT::detect reports it; response = |interpolated contrast|
+    float peak;             // |DoG| at the sample where the extremum was found
+    float edgeRatio;        // trace^2 / det of the 2x2 spatial Hessian (det > 0)
+};
+
+inline void buildDoGPyramid(const cv::Mat& gray, DoGPyramid& pyr, int nOctaveLayers = 3,
+                            double sigma = 1.6, bool doubleImage = true) {
+    CV_Assert(gray.type() == CV_8UC1 && nOctaveLayers >= 1);
+    const int layers = nOctaveLayers + 3;
+    pyr.nOctaveLayers = nOctaveLayers;
+    pyr.sigma = sigma;
+    pyr.firstOctave = doubleImage ? -1 : 0;
+
+    // Octave 0 base at `sigma`; the input counts as already blurred by 0.5
+    // (1.0 once doubled), as in SIFT
+    cv::Mat base;
+    gray.convertTo(base, CV_32F);
+    if (doubleImage) cv::resize(base, base, cv::Size(gray.cols * 2, gray.rows * 2), 0, 0, cv::INTER_LINEAR);
+    const double initSigma = doubleImage ? 1.0 : 0.5;
+    const double baseBlur = std::sqrt(std::max(sigma * sigma - initSigma * initSigma, 0.01));
+    cv::GaussianBlur(base, base, cv::Size(), baseBlur, baseBlur);
+
+    pyr.nOctaves = std::max(cvRound(std::log((double)std::min(base.cols, base.rows)) / std::log(2.0) - 2)
+                            - pyr.firstOctave, 1);
+    pyr.gauss.assign(pyr.nOctaves * layers, cv::Mat());
+    pyr.dog.assign(pyr.nOctaves * (nOctaveLayers + 2), cv::Mat());
+    pyr.gauss[0] = base;
+
+    // Layer i of an octave sits at sigma * k^i, i.e. a blur of
+    // sigma * sqrt(k^2i - 1) on top of the octave base
+    const double k = std::pow(2.0, 1.0 / nOctaveLayers);
+    auto layerBlur = [&](int i) { return sigma * std::sqrt(std::pow(k, 2.0 * i) - 1); };
+
+    // The only sequential part: the next base is layer nOctaveLayers (twice
+    // the base sigma) taken every other pixel
+    for (int o = 0; o + 1 < pyr.nOctaves; o++) {
+        cv::Mat& twice = pyr.gauss[o * layers + nOctaveLayers];
+        const double s = layerBlur(nOctaveLayers);
+        cv::GaussianBlur(pyr.gauss[o * layers], twice, cv::Size(), s, s);
+        cv::resize(twice, pyr.gauss[(o + 1) * layers], cv::Size(twice.cols / 2, twice.rows / 2),
+                   0, 0, cv::INTER_NEAREST);
+    }
+
+    std::vector<int> pending;
+    for (int idx = 0; idx < (int)pyr.gauss.size(); idx++)
+        if (pyr.gauss[idx].empty()) pending.push_back(idx);
+    cv::parallel_for_(cv::Range(0, (int)pending.size()), [&](const cv::Range& range) {
+        for (int t = range.start; t < range.end; t++) {
+            const int o = pending[t] / layers, i = pending[t] % layers;
+            const double s = layerBlur(i);
+            cv::GaussianBlur(pyr.gauss[o * layers], pyr.gauss[pending[t]], cv::Size(), s, s);
+        }
+    });
+
+    cv::parallel_for_(cv::Range(0, (int)pyr.dog.size()), [&](const cv::Range& range) {
+        for (int t = range.start; t < range.end; t++) {
+            const int o = t / (nOctaveLayers + 2), i = t % (nOctaveLayers + 2);
+            cv::subtract(pyr.gauss[o * layers + i + 1], pyr.gauss[o * layers + i], pyr.dog[t]);
+        }
+    });
+}
+
+// Solves H x = b for the 3x3 Hessian by Cramer's rule; x = 0 when H is
+// singular (what Matx33f::solve gives SIFT)
+inline double dogDet3(double a, double b, double c, double d, double e, double f,
+                      double g, double h, double i) {
+    return a * (e * i - f * h) - b * (d * i - f * g) + c * (d * h - e * g);
+}
+
+inline void solveDoGHessian(const float H[9], const float b[3], float x[3]) {
+    const double det = dogDet3(H[0], H[1], H[2], H[3], H[4], H[5], H[6], H[7], H[8]);
+    if (det == 0) {
+        x[0] = x[1] = x[2] = 0;
+        return;
+    }
+    x[0] = (float)(dogDet3(b[0], H[1], H[2], b[1], H[4], H[5], b[2], H[7], H[8]) / det);
+    x[1] = (float)(dogDet3(H[0], b[0], H[2], H[3], b[1], H[5], H[6], b[2], H[8]) / det);
+    x[2] = (float)(dogDet3(H[0], H[1], b[0], H[3], H[4], b[1], H[6], H[7], b[2]) / det);
+}
+
+// SIFT's quadratic fit around the extremum at (layer, r, c) of octave o:
+// steps to the nearest sample of the interpolated extremum up to 5 times.
+// False when it does not converge, leaves the scan area, or falls below
+// minContrast or on a saddle (det <= 0); otherwise fills `cand` except the
+// orientation and the firstOctave rescale.
+inline bool refineDoGExtremum(const DoGPyramid& pyr, int o, int& layer, int& r, int& c,
+                              double minContrast, DoGCandidate& cand) {
+    const int border = 5, maxSteps = 5;
+    const float scale = 1.f / 255, derivScale = scale * 0.5f, crossScale = scale * 0.25f;
+    const int L = pyr.nOctaveLayers;
+    float xi = 0, xr = 0, xc = 0;
+    float grad[3], H[9];
+
+    auto derivatives = [&]() {
+        const int idx = o * (L + 2) + layer;
+        const cv::Mat& img = pyr.dog[idx];
+        const cv::Mat& prev = pyr.dog[idx - 1];
+        const cv::Mat& next = pyr.dog[idx + 1];
+        const float* p = img.ptr<float>(r);
+        const float* up = img.ptr<float>(r - 1);
+        const float* down = img.ptr<float>(r + 1);
+        const float* pp = prev.ptr<float>(r);
+        const float* np = next.ptr<float>(r);
+        const float v2 = p[c] * 2;
+        grad[0] = (p[c + 1] - p[c - 1]) * derivScale;
+        grad[1] = (down[c] - up[c]) * derivScale;
+        grad[2] = (np[c] - pp[c]) * derivScale;
+        H[0] = (p[c + 1] + p[c - 1] - v2) * scale;
+        H[4] = (down[c] + up[c] - v2) * scale;
+        H[8] = (np[c] + pp[c] - v2) * scale;
+        H[1] = H[3] = (down[c + 1] - down[c - 1] - up[c + 1] + up[c - 1]) * crossScale;
+        H[2] = H[6] = (np[c + 1] - np[c - 1] - pp[c + 1] + pp[c - 1]) * crossScale;
+        H[5] = H[7] = (next.ptr<float>(r + 1)[c] - next.ptr<float>(r - 1)[c]
+                     - prev.ptr<float>(r + 1)[c] + prev.ptr<float>(r - 1)[c]) * crossScale;
+    };
+
+    int step = 0;
+    for (; step < maxSteps; step++) {
+        derivatives();
+        float x[3];
+        solveDoGHessian(H, grad, x);
+        xc = -x[0]; xr = -x[1]; xi = -x[2];
+        if (std::abs(xi) < 0.5f && std::abs(xr) < 0.5f && std::abs(xc) < 0.5f) break;
+        if (std::abs(xi) > (float)(INT_MAX / 3) || std::abs(xr) > (float)(INT_MAX / 3) ||
+            std::abs(xc) > (float)(INT_MAX / 3)) return false;
+
+        c += cvRound(xc); r += cvRound(xr); layer += cvRound(xi);
+        const cv::Mat& img = pyr.dog[o * (L + 2)];
+        if (layer < 1 || layer > L || c < border || c >= img.cols - border ||
+            r < border || r >= img.rows - border) return false;
+    }
+    if (step >= maxSteps) return false;
+
+    derivatives();
+    const float value = pyr.dog[o * (L + 2) + layer].ptr<float>(r)[c];
+    const float contrast = value * scale + 0.5f * (grad[0] * xc + grad[1] * xr + grad[2] * xi);
+    if (std::abs(contrast) * L < minContrast) return false;
+
+    const float trace = H[0] + H[4], det = H[0] * H[4] - H[1] * H[1];
+    if (det <= 0) return false;
+
+    cand.keypoint.pt.x = (c + xc) * (1 << o);
+    cand.keypoint.pt.y = (r + xr) * (1 << o);
+    cand.keypoint.octave = o + (layer << 8) + (cvRound((xi + 0.5) * 255) << 16);
+    cand.keypoint.size = (float)(pyr.sigma * std::pow(2.0, (layer + xi) / L) * (1 << o) * 2);
+    cand.keypoint.response = std::abs(contrast);
+    cand.edgeRatio = trace * trace / det;
+    return true;
+}
+
+// SIFT's 36-bin gradient orientation histogram around `pt` (Gaussian
+// weighted, smoothed with [1 4 6 4 1] / 16); returns the largest bin
+inline float dogOrientationHist(const cv::Mat& img, cv::Point pt, int radius, float sigma,
+                                float* hist, int n) {
+    std::vector<float> temp(n + 4, 0.f);
+    float* bins = &temp[2];
+    const float expScale = -1.f / (2.f * sigma * sigma);
+
+    for (int i = -radius; i <= radius; i++) {
+        const int y = pt.y + i;
+        if (y <= 0 || y >= img.rows - 1) continue;
+        const float* row = img.ptr<float>(y);
+        const float* up = img.ptr<float>(y - 1);
+        const float* down = img.ptr<float>(y + 1);
+        for (int j = -radius; j <= radius; j++) {
+            const int x = pt.x + j;
+            if (x <= 0 || x >= img.cols - 1) continue;
+            const float dx = row[x + 1] - row[x - 1];
+            const float dy = up[x] - down[x];
+            const float weight = std::exp((i * i + j * j) * expScale);
+            int bin = cvRound((n / 360.f) * cv::fastAtan2(dy, dx));
+            if (bin >= n) bin -= n;
+            if (bin < 0) bin += n;
+            bins[bin] += weight * std::sqrt(dx * dx + dy * dy);
+        }
+    }
+
+    bins[-1] = bins[n - 1];
+    bins[-2] = bins[n - 2];
+    bins[n] = bins[0];
+    bins[n + 1] = bins[1];
+    float maxValue = 0;
+    for (int i = 0; i < n; i++) {
+        hist[i] = (bins[i - 2] + bins[i + 2]) * (1.f / 16) + (bins[i - 1] + bins[i + 1]) * (4.f / 16)
+                + bins[i] * (6.f / 16);
+        maxValue = std::max(maxValue, hist[i]);
+    }
+    return maxValue;
+}
+
+// Every refined extremum with contrast >= minContrast, once per dominant
+// orientation (peaks within 80% of the strongest, as SIFT). Candidates keep
+// their contrast, peak and edge ratio, so filterDoGCandidates can apply any
+// contrastThreshold >= minContrast and any edgeThreshold without rescanning.
+inline void findDoGCandidates(const DoGPyramid& pyr, double minContrast,
+                              std::vector<DoGCandidate>& candidates) {
+    const int L = pyr.nOctaveLayers, border = 5, bins = 36;
+    const float threshold = (float)std::floor(0.5 * minContrast / L * 255);
+    const int tasks = pyr.nOctaves * L;
+    std::vector<std::vector<DoGCandidate> > found(tasks);
+
+    cv::parallel_for_(cv::Range(0, tasks), [&](const cv::Range& range) {
+        float hist[bins];
+        for (int t = range.start; t < range.end; t++) {
+            const int o = t / L, layer = t % L + 1;
+            const int idx = o * (L + 2) + layer;
+            const cv::Mat& img = pyr.dog[idx];
+            const cv::Mat& prev = pyr.dog[idx - 1];
+            const cv::Mat& next = pyr.dog[idx + 1];
+            std::vector<DoGCandidate>& out = found[t];
+
+            for (int r = border; r < img.rows - border; r++) {
+                const float* rows[9];
+                for (int d = -1; d <= 1; d++) {
+                    rows[d + 1] = prev.ptr<float>(r + d);
+                    rows[d + 4] = img.ptr<float>(r + d);
+                    rows[d + 7] = next.ptr<float>(r + d);
+                }
+                const float* cur = rows[4];
+
+                // 26-neighbour test (ties allowed, as SIFT), then refinement
+                // and one candidate per dominant orientation
+                auto tryExtremum = [&](int c) {
+                    const float v = cur[c];
+                    if (std::abs(v) <= threshold) return;
+                    for (int k = 0; k < 9; k++) {
+                        const float* p = rows[k];
+                        for (int dc = -1; dc <= 1; dc++) {
+                            if (k == 4 && dc == 0) continue;
+                            if (v > 0 ? p[c + dc] > v : p[c + dc] < v) return;
+                        }
+                    }
+
+                    DoGCandidate cand;
+                    cand.peak = std::abs(v);
+                    int l2 = layer, r2 = r, c2 = c;
+                    if (!refineDoGExtremum(pyr, o, l2, r2, c2, minContrast, cand)) return;
+
+                    const float octaveScale = cand.keypoint.size * 0.5f / (1 << o);
+                    const float maxBin = dogOrientationHist(pyr.gauss[o * (L + 3) + l2], cv::Point(c2, r2),
+                                                            cvRound(4.5f * octaveScale), 1.5f * octaveScale,
+                                                            hist, bins);
+                    for (int j = 0; j < bins; j++) {
+                        const int left = j > 0 ? j - 1 : bins - 1, right = j < bins - 1 ? j + 1 : 0;
+                        if (hist[j] <= hist[left] || hist[j] <= hist[right] || hist[j] < 0.8f * maxBin) continue;
+                        float bin = j + 0.5f * (hist[left] - hist[right]) / (hist[left] - 2 * hist[j] + hist[right]);
+                        bin = bin < 0 ? bins + bin : bin >= bins ? bin - bins : bin;
+                        DoGCandidate oriented = cand;
+                        oriented.keypoint.angle = 360.f - (360.f / bins) * bin;
+                        if (std::abs(oriented.keypoint.angle - 360.f) < FLT_EPSILON) oriented.keypoint.angle = 0.f;
+                        // Back to input-image coordinates (SIFT's firstOctave step)
+                        if (pyr.firstOctave < 0) {
+                            const float s = 1.f / (1 << -pyr.firstOctave);
+                            cv::KeyPoint& kp = oriented.keypoint;
+                            kp.octave = (kp.octave & ~255) | ((kp.octave + pyr.firstOctave) & 255);
+                            kp.pt *= s;
+                            kp.size *= s;
+                        }
+                        out.push_back(oriented);
+                    }
+                };
+
+                int c = border;
+                const int end = img.cols - border;
+#if CV_SIMD
+                // Most samples are under the pre-threshold: test a vector of
+                // them at once and only look closer when one passes
+                const int lanes = cv::v_float32::nlanes;
+                cv::v_float32 vthreshold = cv::vx_setall_f32(threshold);
+                for (; c <= end - lanes; c += lanes) {
+                    if (!cv::v_check_any(cv::v_abs(cv::vx_load(cur + c)) > vthreshold)) continue;
+                    for (int j = c; j < c + lanes; j++) tryExtremum(j);
+                }
+#endif
+                for (; c < end; c++) tryExtremum(c);
+            }
+        }
+    });
+
+    candidates.clear();
+    for (size_t t = 0; t < found.size(); t++)
+        candidates.insert(candidates.end(), found[t].begin(), found[t].end());
+}
+
+// SIFT's keypoint set for contrastThreshold >= the candidates' minContrast
+// and edgeThreshold: pre-threshold on the raw peak, contrast and edge tests,
+// duplicates removed, then the strongest maxFeatures (0 keeps all)
+inline void filterDoGCandidates(const std::vector<DoGCandidate>& candidates, int nOctaveLayers,
+                                double contrastThreshold, double edgeThreshold,
+                                std::vector<cv::KeyPoint>& keypoints, int maxFeatures = 0) {
+    const float peakThreshold = (float)std::floor(0.5 * contrastThreshold / nOctaveLayers * 255);
+    const double edgeLimit = edgeThreshold > 0 ? (edgeThreshold + 1) * (edgeThreshold + 1) / edgeThreshold : DBL_MAX;
+    keypoints.clear();
+    for (size_t i = 0; i < candidates.size(); i++) {
+        const DoGCandidate& cand = candidates[i];
+        if (cand.peak > peakThreshold && cand.keypoint.response * nOctaveLayers >= contrastThreshold &&
+            cand.edgeRatio < edgeLimit)
+            keypoints.push_back(cand.keypoint);
+    }
+    cv::KeyPointsFilter::removeDuplicatedSorted(keypoints);
+    if (maxFeatures > 0) cv::KeyPointsFilter::retainBest(keypoints, maxFeatures);
+}
+
+// Detection on an already built pyramid (e.g. from ImagePyramid::dog())
+inline void detectDoGInPyramid(const DoGPyramid& pyr, std::vector<cv::KeyPoint>& keypoints,
+                               double contrastThreshold = 0.04, double edgeThreshold = 10,
+                               int maxFeatures = 0) {
+    std::vector<DoGCandidate> candidates;
+    findDoGCandidates(pyr, contrastThreshold, candidates);
+    filterDoGCandidates(candidates, pyr.nOctaveLayers, contrastThreshold, edgeThreshold, keypoints, maxFeatures);
+}
+
+// Drop-in for SIFT::create(maxFeatures, nOctaveLayers, contrastThreshold,
+// edgeThreshold, sigma)->detect(gray, keypoints)
+inline void detectDoGNative(const cv::Mat& gray, std::vector<cv::KeyPoint>& keypoints,
+                            int nOctaveLayers = 3, double contrastThreshold = 0.04,
+                            double edgeThreshold = 10, double sigma = 1.6, int maxFeatures = 0) {
+    DoGPyramid pyr;
+    buildDoGPyramid(gray, pyr, nOctaveLayers, sigma);
+    detectDoGInPyramid(pyr, keypoints, contrastThreshold, edgeThreshold, maxFeatures);
+}
+
+#endif // DOG_DETECTOR_HPP
@@ -3,6 +3,11 @@
 #include <opencv2/imgproc.hpp>
 #include <iostream>
 #include <string>
+#include <vector>
+
+#include "harris_core.hpp"
+#include "harris_kernel.hpp"
+#include "keypoint_select.hpp"
 
 using namespace cv;
 using namespace std;
@@ -12,14 +17,41 @@ int blockSize = 2;
 int apertureSize = 3;
 int kValue = 4; // k * 100 (for 0.04)
 int cornerThreshold = 200;
+int targetCorners = 0;      // 0 = use Threshold, otherwise keep ~N strongest pixels
 const int MAX_THRESHOLD = 255;
 const int MAX_BLOCK_SIZE = 10;
 const int MAX_APERTURE = 7;
 const int MAX_K_VALUE = 10;
+const int MAX_TARGET_CORNERS = 5000;
 
 Mat srcImage, srcGray, dstImage, dstNorm, dstNormScaled;
 const string windowName = "Harris Corner Detection";
 bool fromCamera = false;
+bool tiledMode = true;     // Multi-threaded row-strip execution
+bool boxWindow = false;    // Integral-image box window instead of Gaussian
+bool specializedKernel = true;  // HarrisKernel<Aperture, Block> for the Gaussian window
+int imageGeneration = 0;   // Bumped for every new srcGray
+
+// Stage cache: every intermediate remembers the parameters it was built
+// from (image generation included), so a trackbar only recomputes the stages
+// downstream of it. Threshold and Target Corners reuse the response as is;
+// on the serial path K reuses the structure tensor and, with the box window,
+// Block Size reuses the integral image as well.
+struct HarrisStageCache {
+    vector<double> gradKey, tensorKey, responseKey;
+    Mat Ixx, Iyy, Ixy;         // Steps 1-2: gradient products (aperture)
+    Mat Sxx, Syy, Sxy;         // Step 3, Gaussian window (aperture, block)
+    Mat boxSums;               // Step 3, box window integral (aperture)
+    Mat response;              // Step 4 (all Harris parameters + path)
+} stages;
+
+// True when a stage built for `stored` is out of date for `key`; the caller
+// then rebuilds it and the new key is remembered.
+bool stageStale(vector<double>& stored, const vector<double>& key) {
+    if (stored == key) return false;
+    stored = key;
+    return true;
+}
 
 void showHelp() {
     cout << "\n===== HARRIS CORNER DETECTION - HELP =====" << endl;
@@ -31,12 +63,16 @@ void showHelp() {
     cout << "  'h' or 'H' - Show this help" << endl;
     cout << "  'r' or 'R' - Reset to original image" << endl;
     cout << "  's' or 'S' - Save current result" << endl;
+    cout << "  't' or 'T' - Toggle tiled multi-threaded mode" << endl;
+    cout << "  'b' or 'B' - Toggle box window (integral images, fast for large blocks)" << endl;
+    cout << "  'k' or 'K' - Toggle compile-time specialized Harris kernels" << endl;
     cout << "  'q' or 'Q' or ESC - Quit" << endl;
     cout << "\nTrackbar Parameters:" << endl;
     cout << "  Block Size    - Size of neighborhood considered for corner detection (2-10)" << endl;
     cout << "  Aperture Size - Aperture parameter for Sobel operator (3, 5, or 7)" << endl;
     cout << "  K Value       - Harris detector free parameter (0-1, displayed as 0-10)" << endl;
     cout << "  Threshold     - Threshold for corner detection (0-255)" << endl;
+    cout << "  Target Corners- Keep about N strongest pixels instead (0 = off)" << endl;
     cout << "\nAlgorithm:" << endl;
     cout << "  Harris Corner Detection identifies corners by analyzing" << endl;
     cout << "  intensity changes in all directions at each pixel." << endl;
@@ -59,64 +95,84 @@ void harrisCornerDetection(int, void*) {
     
     // ========== MANUAL HARRIS IMPLEMENTATION ==========
     
-    // Step 1: Compute image gradients using Sobel (Ix and Iy)
-    Mat Ix, Iy;
-    Sobel(srcGray, Ix, CV_32F, 1, 0, actualApertureSize);  // Gradient in X
-    Sobel(srcGray, Iy, CV_32F, 0, 1, actualApertureSize);  // Gradient in Y
-    
-    // Step 2: Compute products of gradients
-    Mat Ixx, Iyy, Ixy;
-    multiply(Ix, Ix, Ixx);  // Ix²
-    multiply(Iy, Iy, Iyy);  // Iy²
-    multiply(Ix, Iy, Ixy);  // Ix·Iy
-    
-    // Step 3: Apply Gaussian smoothing to gradient products
-    // This creates the structure tensor M at each pixel
-    Mat Sxx, Syy, Sxy;
-    int kernelSize = actualBlockSize * 2 + 1;  // Make it odd
-    GaussianBlur(Ixx, Sxx, Size(kernelSize, kernelSize), 0);
-    GaussianBlur(Iyy, Syy, Size(kernelSize, kernelSize), 0);
-    GaussianBlur(Ixy, Sxy, Size(kernelSize, kernelSize), 0);
-    
-    // Step 4: Compute Harris corner response at each pixel
-    // R = det(M) - k * trace(M)²
-    // det(M) = Sxx * Syy - Sxy²
-    // trace(M) = Sxx + Syy
-    Mat harrisResponse(srcGray.size(), CV_32F);
-    
-    for (int i = 0; i < srcGray.rows; i++) {
-        for (int j = 0; j < srcGray.cols; j++) {
-            float sxx = Sxx.at<float>(i, j);
-            float syy = Syy.at<float>(i, j);
-            float sxy = Sxy.at<float>(i, j);
-            
-            // Compute determinant and trace
-            float det = sxx * syy - sxy * sxy;
-            float trace = sxx + syy;
-            
-            // Harris corner response
-            float response = det - k * trace * trace;
-            harrisResponse.at<float>(i, j) = response;
+    // Steps 1-4 (see harris_core.hpp):
+    //   Sobel gradients Ix, Iy -> products Ix², Iy², Ix·Iy ->
+    //   Gaussian-weighted structure tensor M -> R = det(M) - k * trace(M)²
+    // Tiled mode runs the same steps on row strips in parallel; the result
+    // is bit-identical to the serial path. Box mode replaces the Gaussian
+    // window with an O(1) box sum, so large block sizes stay cheap.
+    // Specialized mode dispatches the trackbar values to a fully unrolled
+    // HarrisKernel<Aperture, Block> instantiation (Gaussian window only).
+    HarrisWindow window = boxWindow ? HARRIS_WINDOW_BOX : HARRIS_WINDOW_GAUSSIAN;
+    // Trackbars keep aperture in 3/5/7 and block in 2-10, all instantiated
+    bool usedKernel = specializedKernel && !boxWindow;
+    int path = usedKernel ? 2 : tiledMode ? 1 : 0;
+
+    double responseArgs[] = { (double)imageGeneration, (double)actualApertureSize, (double)actualBlockSize,
+                              k, (double)window, (double)path };
+    bool rebuilt = stageStale(stages.responseKey, vector<double>(responseArgs, responseArgs + 6));
+    if (!rebuilt) {
+        // Threshold / Target Corners only: reuse the response
+    } else if (usedKernel) {
+        computeHarrisSpecialized(srcGray, stages.response, actualBlockSize, actualApertureSize, k);
+    } else if (tiledMode) {
+        computeHarrisTiled(srcGray, stages.response, actualBlockSize, actualApertureSize, k, 0, window);
+    } else {
+        // Serial path, one cached stage at a time
+        double gradArgs[] = { (double)imageGeneration, (double)actualApertureSize };
+        double tensorArgs[] = { (double)imageGeneration, (double)actualApertureSize, (double)window,
+                                window == HARRIS_WINDOW_BOX ? 0.0 : (double)actualBlockSize };
+
+        // Steps 1-2: Sobel gradients and their products
+        if (stageStale(stages.gradKey, vector<double>(gradArgs, gradArgs + 2))) {
+            Mat Ix, Iy;
+            Sobel(srcGray, Ix, CV_32F, 1, 0, actualApertureSize);
+            Sobel(srcGray, Iy, CV_32F, 0, 1, actualApertureSize);
+            multiply(Ix, Ix, stages.Ixx);
+            multiply(Iy, Iy, stages.Iyy);
+            multiply(Ix, Iy, stages.Ixy);
+        }
+
+        // Step 3: windowed structure tensor (or the box integral)
+        if (stageStale(stages.tensorKey, vector<double>(tensorArgs, tensorArgs + 4))) {
+            if (window == HARRIS_WINDOW_BOX) {
+                harrisBoxIntegral(stages.Ixx, stages.Iyy, stages.Ixy, stages.boxSums);
+            } else {
+                Size ksize(actualBlockSize * 2 + 1, actualBlockSize * 2 + 1);
+                GaussianBlur(stages.Ixx, stages.Sxx, ksize, 0);
+                GaussianBlur(stages.Iyy, stages.Syy, ksize, 0);
+                GaussianBlur(stages.Ixy, stages.Sxy, ksize, 0);
+            }
+        }
+
+        // Step 4: R = det(M) - k * trace(M)^2
+        if (window == HARRIS_WINDOW_BOX) {
+            harrisBoxResponse(stages.boxSums, stages.response, actualBlockSize, k);
+        } else {
+            computeHarrisResponse(stages.Sxx, stages.Syy, stages.Sxy, stages.response, k);
         }
     }
+    const Mat& harrisResponse = stages.response;
     
-    // Step 5: Normalize the response for visualization
-    normalize(harrisResponse, dstNorm, 0, 255, NORM_MINMAX, CV_32FC1, Mat());
-    convertScaleAbs(dstNorm, dstNormScaled);
+    // Step 5: Normalize the response for visualization (only when it changed)
+    if (rebuilt) {
+        normalize(harrisResponse, dstNorm, 0, 255, NORM_MINMAX, CV_32FC1, Mat());
+        convertScaleAbs(dstNorm, dstNormScaled);
+    }
     
     // ========== END MANUAL IMPLEMENTATION ==========
     
     // Draw corners on the original image (OPTIMIZED)
     Mat resultImage = srcImage.clone();
     
-    // Use thresholding instead of nested loops for better speedup
-    Mat cornerMask;
-    threshold(dstNorm, cornerMask, cornerThreshold, 255, THRESH_BINARY);
-    cornerMask.convertTo(cornerMask, CV_8U);
-    
-    // Find corner locations efficiently
+    // Find corner locations in one scan. Target mode picks the raw-response
+    // cutoff from a histogram so the count stays predictable across images.
     vector<Point> corners;
-    findNonZero(cornerMask, corners);
+    if (targetCorners > 0) {
+        collectAboveThreshold(harrisResponse, countThreshold(harrisResponse, targetCorners), corners);
+    } else {
+        collectAboveThreshold(dstNorm, (float)cornerThreshold, corners);
+    }
     int cornerCount = corners.size();
     
     // Draw corners (much faster with vector)
@@ -133,7 +189,12 @@ void harrisCornerDetection(int, void*) {
     string params = "Block:" + to_string(actualBlockSize) + 
                    " Aperture:" + to_string(actualApertureSize) +
                    " K:" + to_string(k).substr(0, 4) +
-                   " Thresh:" + to_string(cornerThreshold);
+                   (targetCorners > 0 ? " Target:" + to_string(targetCorners)
+                                      : " Thresh:" + to_string(cornerThreshold)) +
+                   (boxWindow ? " Box" : " Gauss") +
+                   (usedKernel ? " Kernel<" + to_string(actualApertureSize) + "," + to_string(actualBlockSize) + ">"
+                               : tiledMode ? " Tiled x" + to_string(getNumThreads()) : " Serial") +
+                   (rebuilt ? "" : " (cached)");
     putText(resultImage, params, Point(10, 60), FONT_HERSHEY_SIMPLEX, 
             0.5, Scalar(255, 255, 0), 1);
     
@@ -142,6 +203,7 @@ void harrisCornerDetection(int, void*) {
 
 void processImage(const Mat& img) {
     srcImage = img.clone();
+    imageGeneration++;
     
     // Convert to grayscale
     if (srcImage.channels() == 3) {
@@ -179,6 +241,7 @@ int main(int argc, char** argv) {
         createTrackbar("Aperture Size", windowName, &apertureSize, MAX_APERTURE, harrisCornerDetection);
         createTrackbar("K Value (x100)", windowName, &kValue, MAX_K_VALUE, harrisCornerDetection);
         createTrackbar("Threshold", windowName, &cornerThreshold, MAX_THRESHOLD, harrisCornerDetection);
+        createTrackbar("Target Corners", windowName, &targetCorners, MAX_TARGET_CORNERS, harrisCornerDetection);
         
         // Process the image
         processImage(image);
@@ -193,6 +256,18 @@ int main(int argc, char** argv) {
             } else if (key == 'r' || key == 'R') {
                 cout << "Resetting to original image..." << endl;
                 processImage(image);
+            } else if (key == 't' || key == 'T') {
+                tiledMode = !tiledMode;
+                cout << "Tiled mode: " << (tiledMode ? "on" : "off") << endl;
+                harrisCornerDetection(0, 0);
+            } else if (key == 'b' || key == 'B') {
+                boxWindow = !boxWindow;
+                cout << "Window: " << (boxWindow ? "box (integral image)" : "Gaussian") << endl;
+                harrisCornerDetection(0, 0);
+            } else if (key == 'k' || key == 'K') {
+                specializedKernel = !specializedKernel;
+                cout << "Specialized kernels: " << (specializedKernel ? "on" : "off") << endl;
+                harrisCornerDetection(0, 0);
             } else if (key == 's' || key == 'S') {
                 string outputPath = "harris_result.jpg";
                 Mat resultImage;
@@ -228,6 +303,7 @@ int main(int argc, char** argv) {
         createTrackbar("Aperture Size", windowName, &apertureSize, MAX_APERTURE, harrisCornerDetection);
         createTrackbar("K Value (x100)", windowName, &kValue, MAX_K_VALUE, harrisCornerDetection);
         createTrackbar("Threshold", windowName, &cornerThreshold, MAX_THRESHOLD, harrisCornerDetection);
+        createTrackbar("Target Corners", windowName, &targetCorners, MAX_TARGET_CORNERS, harrisCornerDetection);
         
         // Continuous capture and processing
         while (true) {
@@ -246,6 +322,15 @@ int main(int argc, char** argv) {
                 break;
             } else if (key == 'h' || key == 'H') {
                 showHelp();
+            } else if (key == 't' || key == 'T') {
+                tiledMode = !tiledMode;
+                cout << "Tiled mode: " << (tiledMode ? "on" : "off") << endl;
+            } else if (key == 'b' || key == 'B') {
+                boxWindow = !boxWindow;
+                cout << "Window: " << (boxWindow ? "box (integral image)" : "Gaussian") << endl;
+            } else if (key == 'k' || key == 'K') {
+                specializedKernel = !specializedKernel;
+                cout << "Specialized kernels: " << (specializedKernel ? "on" : "off") << endl;
             } else if (key == 's' || key == 'S') {
                 string outputPath = "harris_result_camera.jpg";
                 imwrite(outputPath, frame);
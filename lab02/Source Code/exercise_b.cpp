@@ -2,8 +2,13 @@
 #include <opencv2/features2d.hpp>
 #include <opencv2/highgui.hpp>
 #include <opencv2/imgproc.hpp>
+#include <cstdlib>
 #include <iostream>
 #include <string>
+#include <vector>
+
+#include "blob_core.hpp"
+#include "filter_cascade.hpp"
 
 using namespace cv;
 using namespace std;
@@ -25,18 +30,53 @@ const int MAX_PERCENTAGE = 100;
 Mat srcImage, resultImage;
 const string windowName = "Blob Detection";
 bool fromCamera = false;
+int imageGeneration = 0;   // Bumped for every new srcImage
+
+// Stage cache: the grayscale image depends only on the input, the threshold
+// levels only on the threshold parameters and blob color. The shape filter
+// trackbars (Min Area, Circularity, Convexity, Inertia) leave both intact,
+// so moving them skips the component tree and every findContours call.
+struct BlobStageCache {
+    int grayImage = -1;
+    Mat gray, colorImage;
+    vector<int> levelKey;
+    vector<LevelComponents> levels; // one per threshold level
+    int levelsSkipped = 0;          // levels with no pixels above the previous one
+    LevelContours midLevel;         // (minThreshold + maxThreshold) / 2, for the shape filters
+    CentroidGrid midIndex;          // midLevel centroids, for the closest-contour lookup
+    vector<double> midPerimeter;    // per midLevel contour, filled on first use (-1 = not yet)
+    vector<double> midHullArea;
+} stages;
+
+// Shape filters, run cheapest-per-rejection first (filter_cascade.hpp); the
+// order is re-tuned after every detection from the measured costs and
+// rejection rates
+enum ShapeFilter { FILTER_AREA, FILTER_INERTIA, FILTER_CIRCULARITY, FILTER_CONVEXITY, FILTER_COUNT };
+const string shapeFilterNames[FILTER_COUNT] = { "area", "inertia", "circularity", "convexity" };
+FilterCascade shapeFilters(vector<string>(shapeFilterNames, shapeFilterNames + FILTER_COUNT));
+
+// Pyramid mode ('p'): detect on a pyrDown copy and refine centers and radii
+// at full resolution inside candidate ROIs. With --fps N (camera), the mode
+// is picked per frame: full resolution while it keeps up with N fps.
+bool pyramidMode = false;
+double targetFps = 0;
+double fullMsAvg = 0, pyramidMsAvg = 0;   // running detection time per mode
+int framesSinceFull = 0;
 
 void showHelp() {
     cout << "\n===== BLOB DETECTION - HELP =====" << endl;
-    cout << "Usage: ./exercise_b [image_file]" << endl;
+    cout << "Usage: ./exercise_b [image_file] [--fps target]" << endl;
     cout << "\nDescription:" << endl;
     cout << "  Detects keypoints using blob detection algorithm" << endl;
     cout << "  If no image file is provided, captures from camera" << endl;
+    cout << "  --fps N: in camera mode, switch to pyramid detection whenever" << endl;
+    cout << "           full resolution falls below N frames per second" << endl;
     cout << "\nKeyboard Controls:" << endl;
     cout << "  'h' or 'H' - Show this help" << endl;
     cout << "  'r' or 'R' - Reset to original image" << endl;
     cout << "  's' or 'S' - Save current result" << endl;
     cout << "  'c' or 'C' - Toggle blob color (dark/bright)" << endl;
+    cout << "  'p' or 'P' - Toggle pyramid mode (half-resolution detection)" << endl;
     cout << "  'q' or 'Q' or ESC - Quit" << endl;
     cout << "\nTrackbar Parameters:" << endl;
     cout << "  Min Threshold  - Minimum threshold for blob detection" << endl;
@@ -52,6 +92,132 @@ void showHelp() {
     cout << "================================\n" << endl;
 }
 
+// Shape filters on one contour through the cascade; `perimeter` and
+// `hullArea` are memo slots for the contour (-1 = not computed yet)
+bool passesShapeFilters(const vector<Point>& contour, const Moments& m, double area,
+                        double& perimeter, double& hullArea) {
+    return shapeFilters.run([&](int filter) {
+        switch (filter) {
+        case FILTER_AREA:
+            return area >= minArea;
+        case FILTER_INERTIA:
+            return inertiaRatio(m.mu20, m.mu11, m.mu02) >= minInertia / 100.0f;
+        case FILTER_CIRCULARITY: {
+            if (perimeter < 0) perimeter = arcLength(contour, true);
+            if (perimeter == 0) return false;
+            double circularity = 4.0 * CV_PI * area / (perimeter * perimeter);
+            return circularity >= minCircularity / 100.0f;
+        }
+        default: {  // FILTER_CONVEXITY
+            if (hullArea < 0) {
+                vector<Point> hull;
+                convexHull(contour, hull);
+                hullArea = contourArea(hull);
+            }
+            if (hullArea == 0) return false;
+            return area / hullArea >= minConvexity / 100.0f;
+        }
+        }
+    });
+}
+
+// Steps 2-3 after the levels: centers of components with at least
+// `levelMinArea` pixels, grouped across thresholds (`radius`), averaged for
+// the groups seen at 2 or more thresholds
+void blobCandidates(const vector<LevelComponents>& levels, double levelMinArea, float radius,
+                    vector<Point2f>& candidates) {
+    vector<vector<Point2f>> allCenters;
+    for (size_t l = 0; l < levels.size(); l++) {
+        const LevelComponents& level = levels[l];
+        vector<Point2f> centersAtThisThreshold;
+        
+        for (size_t i = 0; i < level.areas.size(); i++) {
+            if (level.areas[i] < levelMinArea) continue;
+            centersAtThisThreshold.push_back(level.centers[i]);
+        }
+        
+        allCenters.push_back(centersAtThisThreshold);
+    }
+    
+    // Centers that are close together across thresholds are the same blob;
+    // neighbours are found through a spatial hash (blob_core.hpp)
+    vector<vector<Point2f>> blobGroups;
+    groupBlobCenters(allCenters, radius, blobGroups);
+    
+    candidates.clear();
+    for (size_t g = 0; g < blobGroups.size(); g++) {
+        if (blobGroups[g].size() < 2) continue;  // Require blob to appear in at least 2 thresholds
+        
+        Point2f avgCenter(0, 0);
+        for (size_t i = 0; i < blobGroups[g].size(); i++) {
+            avgCenter += blobGroups[g][i];
+        }
+        avgCenter.x /= blobGroups[g].size();
+        avgCenter.y /= blobGroups[g].size();
+        candidates.push_back(avgCenter);
+    }
+}
+
+// Pyramid mode: levels and candidates on a pyrDown copy (min area / 4,
+// grouping radius / 2), then each candidate's middle-threshold contour is
+// extracted again at full resolution inside its ROI (the half-resolution
+// contour's box, doubled and padded) and shape-filtered there. Centers and
+// radii come from the full-resolution contour. Returns the skipped levels.
+int detectBlobsPyramid(const Mat& gray, const vector<int>& thresholds, int midThresh,
+                       vector<KeyPoint>& keypoints) {
+    Mat half;
+    pyrDown(gray, half);
+    
+    vector<LevelComponents> levels;
+    LevelContours midHalf;
+    int skipped = 0;
+    parallel_for_(Range(0, 2), [&](const Range& range) {
+        for (int task = range.start; task < range.end; task++) {
+            if (task == 0) skipped = componentLevels(half, thresholds, blobColor, levels);
+            else extractLevel(half, midThresh, blobColor, midHalf);
+        }
+    });
+    CentroidGrid midIndex;
+    midIndex.build(midHalf, 5.0f);
+    
+    vector<Point2f> candidates;
+    blobCandidates(levels, minArea / 4.0, 2.5f, candidates);
+    
+    const Rect frame(0, 0, gray.cols, gray.rows);
+    LevelContours roiLevel;
+    Mat binary;
+    keypoints.clear();
+    for (size_t c = 0; c < candidates.size(); c++) {
+        int coarse = midIndex.nearest(candidates[c], 5.0);
+        if (coarse == -1) continue;
+        
+        Rect box = boundingRect(midHalf.contours[coarse]);
+        Rect roi = Rect(box.x * 2 - 4, box.y * 2 - 4, box.width * 2 + 8, box.height * 2 + 8) & frame;
+        extractLevel(gray(roi), midThresh, blobColor, roiLevel, binary);
+        
+        // Full-resolution contour closest to the candidate, at most 10 px away
+        Point2f center(candidates[c].x * 2 - roi.x, candidates[c].y * 2 - roi.y);
+        int best = -1;
+        double minDist = 10.0;
+        for (size_t i = 0; i < roiLevel.contours.size(); i++) {
+            if (roiLevel.moments[i].m00 == 0) continue;
+            double dist = norm(center - roiLevel.centers[i]);
+            if (dist <= minDist) {
+                minDist = dist;
+                best = (int)i;
+            }
+        }
+        if (best == -1) continue;
+        
+        double area = roiLevel.areas[best], perimeter = -1, hullArea = -1;
+        if (!passesShapeFilters(roiLevel.contours[best], roiLevel.moments[best], area, perimeter, hullArea)) continue;
+        
+        Point2f refined(roiLevel.centers[best].x + roi.x, roiLevel.centers[best].y + roi.y);
+        keypoints.push_back(KeyPoint(refined, 2 * sqrt(area / CV_PI)));
+    }
+    return skipped;
+}
+
 void blobDetection(int, void*) {
     if (srcImage.empty()) return;
     
@@ -77,171 +243,109 @@ void blobDetection(int, void*) {
     
     // ========== MANUAL MULTI-THRESHOLD BLOB DETECTION ==========
     
-    // Keep color image for display
-    Mat colorImage = srcImage.clone();
-    
-    // Step 1: Convert to grayscale for detection
-    Mat gray;
-    if (srcImage.channels() == 3) {
-        cvtColor(srcImage, gray, COLOR_BGR2GRAY);
-    } else {
-        gray = srcImage.clone();
-        cvtColor(gray, colorImage, COLOR_GRAY2BGR);
+    // Step 1: Convert to grayscale for detection (once per image); keep the
+    // color image for display
+    if (stages.grayImage != imageGeneration) {
+        stages.colorImage = srcImage.clone();
+        if (srcImage.channels() == 3) {
+            cvtColor(srcImage, stages.gray, COLOR_BGR2GRAY);
+        } else {
+            stages.gray = srcImage.clone();
+            cvtColor(stages.gray, stages.colorImage, COLOR_GRAY2BGR);
+        }
+        stages.grayImage = imageGeneration;
+        stages.levelKey.clear();
     }
+    const Mat& gray = stages.gray;
+    const Mat& colorImage = stages.colorImage;
     
-    // Step 2: Multi-threshold detection (OPTIMIZED)
-    vector<vector<Point2f>> allCenters;  // Centers at each threshold level
-    int thresholdStep = 20;  // Increased from 10 for better performance
-    
-    cout << "Detecting blobs across " << ((maxThreshold - minThreshold) / thresholdStep) << " threshold levels..." << flush;
-    
+    // Step 2: Multi-threshold detection
+    // The component tree costs one pass over the image however many levels
+    // are read from it, so the step is back to SimpleBlobDetector's 10
+    int thresholdStep = 10;
+    int midThresh = (minThreshold + maxThreshold) / 2;
+    vector<int> thresholds;
     for (int thresh = minThreshold; thresh < maxThreshold; thresh += thresholdStep) {
-        // Apply threshold
-        Mat binary;
-        if (blobColor == 255) {
-            threshold(gray, binary, thresh, 255, THRESH_BINARY);
-        } else {
-            threshold(gray, binary, thresh, 255, THRESH_BINARY_INV);
-        }
-        
-        // Find contours
-        vector<vector<Point>> contours;
-        findContours(binary, contours, RETR_LIST, CHAIN_APPROX_SIMPLE);
-        
-        // Store centers of blobs at this threshold
-        vector<Point2f> centersAtThisThreshold;
-        
-        for (size_t i = 0; i < contours.size(); i++) {
-            double area = contourArea(contours[i]);
-            if (area < minArea) continue;
-            
-            // Calculate center
-            Moments m = moments(contours[i]);
-            if (m.m00 == 0) continue;
-            
-            Point2f center(m.m10 / m.m00, m.m01 / m.m00);
-            centersAtThisThreshold.push_back(center);
-        }
-        
-        allCenters.push_back(centersAtThisThreshold);
+        thresholds.push_back(thresh);
     }
     
-    // Step 3: Group blob centers across thresholds
-    // Centers that are close together across thresholds are the same blob
-    vector<vector<Point2f>> blobGroups;
-    vector<bool> used(allCenters.size());
+    // Camera frames are detected continuously: no per-frame progress output
+    bool verbose = !fromCamera;
     
-    for (size_t i = 0; i < allCenters.size(); i++) {
-        for (size_t j = 0; j < allCenters[i].size(); j++) {
-            Point2f center = allCenters[i][j];
-            
-            // Find if this center belongs to an existing group
-            bool foundGroup = false;
-            for (size_t g = 0; g < blobGroups.size(); g++) {
-                // Check if close to any center in this group
-                for (size_t k = 0; k < blobGroups[g].size(); k++) {
-                    float dist = norm(center - blobGroups[g][k]);
-                    if (dist < 5.0) {  // Distance threshold for grouping
-                        blobGroups[g].push_back(center);
-                        foundGroup = true;
-                        break;
-                    }
-                }
-                if (foundGroup) break;
-            }
-            
-            // Create new group if not found
-            if (!foundGroup) {
-                vector<Point2f> newGroup;
-                newGroup.push_back(center);
-                blobGroups.push_back(newGroup);
-            }
-        }
+    bool usePyramid = pyramidMode;
+    if (fromCamera && targetFps > 0) {
+        // Full resolution while it meets the target; otherwise the pyramid,
+        // with full resolution re-measured every 30 frames
+        usePyramid = fullMsAvg > 0 && 1000.0 / fullMsAvg < targetFps && ++framesSinceFull < 30;
+        if (!usePyramid) framesSinceFull = 0;
     }
     
-    // Step 4: Calculate final blob centers and filter
+    int64 detectStart = getTickCount();
     vector<KeyPoint> keypoints;
+    int levelsSkipped;
     
-    for (size_t g = 0; g < blobGroups.size(); g++) {
-        if (blobGroups[g].size() < 2) continue;  // Require blob to appear in at least 2 thresholds
-        
-        // Calculate average center
-        Point2f avgCenter(0, 0);
-        for (size_t i = 0; i < blobGroups[g].size(); i++) {
-            avgCenter += blobGroups[g][i];
-        }
-        avgCenter.x /= blobGroups[g].size();
-        avgCenter.y /= blobGroups[g].size();
-        
-        // Get contour at middle threshold for filtering
-        int midThresh = (minThreshold + maxThreshold) / 2;
-        Mat binary;
-        if (blobColor == 255) {
-            threshold(gray, binary, midThresh, 255, THRESH_BINARY);
-        } else {
-            threshold(gray, binary, midThresh, 255, THRESH_BINARY_INV);
+    if (usePyramid) {
+        if (verbose) cout << "Detecting blobs on the half-resolution pyramid level..." << flush;
+        levelsSkipped = detectBlobsPyramid(gray, thresholds, midThresh, keypoints);
+    } else {
+        int levelArgs[] = { imageGeneration, minThreshold, maxThreshold, thresholdStep, blobColor };
+        vector<int> levelKey(levelArgs, levelArgs + 5);
+        bool rebuilt = stages.levelKey != levelKey;
+        if (rebuilt) {
+            if (verbose) cout << "Detecting blobs across " << thresholds.size() << " threshold levels..." << flush;
+            
+            // Components of every level from one component tree, and the middle
+            // level's contours for the shape filters, side by side (blob_core.hpp)
+            parallel_for_(Range(0, 2), [&](const Range& range) {
+                for (int task = range.start; task < range.end; task++) {
+                    if (task == 0) stages.levelsSkipped = componentLevels(gray, thresholds, blobColor, stages.levels);
+                    else extractLevel(gray, midThresh, blobColor, stages.midLevel);
+                }
+            });
+            stages.midIndex.build(stages.midLevel, 10.0f);
+            stages.midPerimeter.assign(stages.midLevel.contours.size(), -1.0);
+            stages.midHullArea.assign(stages.midLevel.contours.size(), -1.0);
+            stages.levelKey = levelKey;
+        } else if (verbose) {
+            cout << "Filtering cached components of " << stages.levels.size() << " threshold levels..." << flush;
         }
+        levelsSkipped = stages.levelsSkipped;
         
-        vector<vector<Point>> contours;
-        findContours(binary, contours, RETR_LIST, CHAIN_APPROX_SIMPLE);
-        
-        // Find contour closest to avgCenter
-        int bestContour = -1;
-        double minDist = 1e9;
+        // Step 3: Group blob centers across thresholds
+        vector<Point2f> candidates;
+        blobCandidates(stages.levels, minArea, 5.0f, candidates);  // Distance threshold for grouping
         
-        for (size_t i = 0; i < contours.size(); i++) {
-            Moments m = moments(contours[i]);
-            if (m.m00 == 0) continue;
+        // Step 4: Calculate final blob centers and filter
+        for (size_t c = 0; c < candidates.size(); c++) {
+            const Point2f& avgCenter = candidates[c];
             
-            Point2f contourCenter(m.m10 / m.m00, m.m01 / m.m00);
-            double dist = norm(avgCenter - contourCenter);
+            // Contour at middle threshold closest to avgCenter, at most 10 px
+            // away: looked up in the centroid grid built with the levels
+            int bestContour = stages.midIndex.nearest(avgCenter, 10.0);
+            if (bestContour == -1) continue;
             
-            if (dist < minDist) {
-                minDist = dist;
-                bestContour = i;
-            }
-        }
-        
-        if (bestContour == -1 || minDist > 10.0) continue;
-        
-        // Apply shape filters
-        double area = contourArea(contours[bestContour]);
-        if (area < minArea) continue;
-        
-        double perimeter = arcLength(contours[bestContour], true);
-        if (perimeter == 0) continue;
-        
-        double circularity = 4.0 * CV_PI * area / (perimeter * perimeter);
-        if (circularity < minCircularity / 100.0f) continue;
-        
-        vector<Point> hull;
-        convexHull(contours[bestContour], hull);
-        double hullArea = contourArea(hull);
-        if (hullArea == 0) continue;
-        
-        double convexity = area / hullArea;
-        if (convexity < minConvexity / 100.0f) continue;
-        
-        Moments m = moments(contours[bestContour]);
-        double denominator = sqrt(pow(2 * m.mu11, 2) + pow(m.mu20 - m.mu02, 2));
-        double ratio = 1.0;
-        
-        if (denominator > 1e-2) {
-            double cosmin = (m.mu20 - m.mu02) / denominator;
-            double sinmin = 2 * m.mu11 / denominator;
-            double imin = 0.5 * (m.mu20 + m.mu02) - 0.5 * (m.mu20 - m.mu02) * cosmin - m.mu11 * sinmin;
-            double imax = 0.5 * (m.mu20 + m.mu02) + 0.5 * (m.mu20 - m.mu02) * cosmin + m.mu11 * sinmin;
-            ratio = imin / imax;
+            // Apply shape filters. Area and inertia come from the cached
+            // moments; perimeter and hull area are computed once per contour
+            // and reused by later groups and trackbar changes
+            double area = stages.midLevel.areas[bestContour];
+            if (!passesShapeFilters(stages.midLevel.contours[bestContour], stages.midLevel.moments[bestContour],
+                                    area, stages.midPerimeter[bestContour], stages.midHullArea[bestContour])) continue;
+            
+            // Create keypoint
+            float radius = sqrt(area / CV_PI);
+            keypoints.push_back(KeyPoint(avgCenter, radius * 2));
         }
-        
-        if (ratio < minInertia / 100.0f) continue;
-        
-        // Create keypoint
-        float radius = sqrt(area / CV_PI);
-        keypoints.push_back(KeyPoint(avgCenter, radius * 2));
     }
     
-    cout << " Done! Found " << keypoints.size() << " blobs." << endl;
+    double detectMs = (getTickCount() - detectStart) * 1000.0 / getTickFrequency();
+    double& modeAvg = usePyramid ? pyramidMsAvg : fullMsAvg;
+    modeAvg = modeAvg > 0 ? 0.9 * modeAvg + 0.1 * detectMs : detectMs;
+    
+    shapeFilters.reorder();
+    if (verbose) {
+        cout << " Done! Found " << keypoints.size() << " blobs in " << detectMs << " ms." << endl;
+        cout << "Filter order: " << shapeFilters.describe() << endl;
+    }
     
     // ========== END MANUAL BLOB DETECTION ==========
     
@@ -269,11 +373,31 @@ void blobDetection(int, void*) {
     putText(resultImage, filters, Point(10, 85), FONT_HERSHEY_SIMPLEX, 
             0.5, Scalar(255, 255, 0), 1);
     
+    // Levels that added no pixels (empty histogram interval) reuse the
+    // previous level's components
+    string levels_str = "Levels:" + to_string(thresholds.size()) +
+                       " (" + to_string(levelsSkipped) + " skipped)";
+    putText(resultImage, levels_str, Point(10, 110), FONT_HERSHEY_SIMPLEX, 
+            0.5, Scalar(255, 255, 0), 1);
+    
+    // Detection rate of the mode used, and the gain over full resolution
+    // once both modes have been measured
+    string fps_str = string(usePyramid ? "Pyramid" : "Full-res") + ": " +
+                     to_string(cvRound(1000.0 / modeAvg)) + " fps";
+    if (usePyramid && fullMsAvg > 0) {
+        int gained = cvRound(1000.0 / pyramidMsAvg - 1000.0 / fullMsAvg);
+        fps_str += " (full-res " + to_string(cvRound(1000.0 / fullMsAvg)) + " fps, " +
+                   (gained >= 0 ? "+" : "") + to_string(gained) + ")";
+    }
+    putText(resultImage, fps_str, Point(10, 135), FONT_HERSHEY_SIMPLEX, 
+            0.5, Scalar(255, 255, 0), 1);
+    
     imshow(windowName, resultImage);
 }
 
 void processImage(const Mat& img) {
     srcImage = img.clone();
+    imageGeneration++;
     
     // Perform blob detection (will handle grayscale conversion internally)
     blobDetection(0, 0);
@@ -282,10 +406,17 @@ void processImage(const Mat& img) {
 int main(int argc, char** argv) {
     showHelp();
     
+    // Image file and options
+    string imagePath;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--fps" && i + 1 < argc) targetFps = atof(argv[++i]);
+        else imagePath = arg;
+    }
+    
     // Check if image file is provided
-    if (argc > 1) {
+    if (!imagePath.empty()) {
         // Read image from file
-        string imagePath = argv[1];
         Mat image = imread(imagePath, IMREAD_COLOR);
         
         if (image.empty()) {
@@ -328,6 +459,10 @@ int main(int argc, char** argv) {
                 blobColor = (blobColor == 0) ? 255 : 0;
                 cout << "Blob color toggled to: " << (blobColor == 0 ? "dark" : "bright") << endl;
                 blobDetection(0, 0);
+            } else if (key == 'p' || key == 'P') {
+                pyramidMode = !pyramidMode;
+                cout << "Pyramid mode: " << (pyramidMode ? "on" : "off") << endl;
+                blobDetection(0, 0);
             }
         }
         
@@ -347,6 +482,7 @@ int main(int argc, char** argv) {
         cap.set(CAP_PROP_FPS, 30);
         
         cout << "Camera opened successfully. Press 'q' or ESC to quit." << endl;
+        if (targetFps > 0) cout << "Target: " << targetFps << " fps (pyramid mode when full resolution is slower)" << endl;
         cout << "Resolution: " << cap.get(CAP_PROP_FRAME_WIDTH) << "x" 
              << cap.get(CAP_PROP_FRAME_HEIGHT) << endl;
         fromCamera = true;
@@ -384,6 +520,11 @@ int main(int argc, char** argv) {
             } else if (key == 'c' || key == 'C') {
                 blobColor = (blobColor == 0) ? 255 : 0;
                 cout << "Blob color toggled to: " << (blobColor == 0 ? "dark" : "bright") << endl;
+            } else if (key == 'p' || key == 'P') {
+                // Manual choice; overrides --fps
+                pyramidMode = !pyramidMode;
+                targetFps = 0;
+                cout << "Pyramid mode: " << (pyramidMode ? "on" : "off") << endl;
             }
         }
         
@@ -1,13 +1,14 @@
 #include <opencv2/opencv.hpp>
 #include <opencv2/features2d.hpp>
-#include <opencv2/xfeatures2d.hpp>
 #include <opencv2/highgui.hpp>
 #include <opencv2/imgproc.hpp>
 #include <iostream>
 #include <string>
+#include <vector>
+
+#include "dog_detector.hpp"
 
 using namespace cv;
-using namespace cv::xfeatures2d;
 using namespace std;
 
 // Global variables for trackbars
@@ -26,6 +27,22 @@ const int MAX_SIGMA = 30;     // 0.0 to 3.0
 Mat srcImage, resultImage;
 const string windowName = "DoG (SIFT) Detection";
 bool fromCamera = false;
+int imageGeneration = 0;   // bumped for every new image/frame
+
+// Detection stages kept between trackbar callbacks (dog_detector.hpp). The
+// pyramid depends only on the image, octave layers and sigma; the extremum
+// candidates keep their contrast and edge ratio, so Contrast and Edge moves
+// only re-filter them. For a still image the candidates are found down to
+// the lowest Contrast position, so no contrast move needs a rescan.
+struct DoGStageCache {
+    int grayImage = -1;
+    Mat gray, colorImage;
+    vector<int> pyramidKey;             // image, octave layers, sigma x10
+    DoGPyramid pyramid;
+    double candidateFloor = -1;         // contrast the candidates were found down to
+    vector<DoGCandidate> candidates;
+} stages;
+const double MIN_CONTRAST = 0.01;
 
 void showHelp() {
     cout << "\n===== DOG (SIFT) DETECTION - HELP =====" << endl;
@@ -51,6 +68,7 @@ void showHelp() {
     cout << "  2. Computing differences between adjacent scales" << endl;
     cout << "  3. Finding local extrema in DoG images" << endl;
     cout << "  4. Filtering low-contrast and edge responses" << endl;
+    cout << "  Steps 1-3 are cached: Contrast and Edge changes only redo step 4" << endl;
     cout << "========================================\n" << endl;
 }
 
@@ -65,69 +83,92 @@ void dogDetection(int, void*) {
     
     // Ensure valid values
     if (actualSigma < 0.1) actualSigma = 0.1;
-    if (actualContrastThresh < 0.01) actualContrastThresh = 0.01;
+    if (actualContrastThresh < MIN_CONTRAST) actualContrastThresh = MIN_CONTRAST;
     if (edgeThreshold < 1) edgeThreshold = 1;
     if (nOctaveLayers < 1) nOctaveLayers = 1;
     
-    try {
-        // Create SIFT detector (SIFT uses DoG internally)
-        Ptr<SIFT> detector = SIFT::create(
-            nFeatures,              // nfeatures (0 = no limit)
-            nOctaveLayers,          // nOctaveLayers
-            actualContrastThresh,   // contrastThreshold
-            edgeThreshold,          // edgeThreshold
-            actualSigma            // sigma
-        );
-        
-        // Detect keypoints (on grayscale srcImage)
-        vector<KeyPoint> keypoints;
-        detector->detect(srcImage, keypoints);
-        
-        // Draw detected keypoints on color image (resultImage already set in processImage)
-        drawKeypoints(resultImage, keypoints, resultImage, 
-                      Scalar(0, 0, 255), 
-                      DrawMatchesFlags::DRAW_RICH_KEYPOINTS);
-        
-        // Display keypoint count and info
-        string info = "DoG Keypoints: " + to_string(keypoints.size());
-        putText(resultImage, info, Point(10, 30), FONT_HERSHEY_SIMPLEX, 
-                0.7, Scalar(0, 255, 0), 2);
-        
-        // Display parameters
-        string params_str = "Features:" + to_string(nFeatures) + 
-                           " Octaves:" + to_string(nOctaveLayers) +
-                           " Contrast:" + to_string(actualContrastThresh).substr(0, 4);
-        putText(resultImage, params_str, Point(10, 60), FONT_HERSHEY_SIMPLEX, 
-                0.5, Scalar(255, 255, 0), 1);
-        
-        string filters = "Edge:" + to_string(edgeThreshold) + " " +
-                        "Sigma:" + to_string(actualSigma).substr(0, 3);
-        putText(resultImage, filters, Point(10, 85), FONT_HERSHEY_SIMPLEX, 
-                0.5, Scalar(255, 255, 0), 1);
-        
-        imshow(windowName, resultImage);
-        
-    } catch (const cv::Exception& e) {
-        cerr << "OpenCV Error: " << e.what() << endl;
-        cerr << "Note: SIFT requires opencv_contrib (xfeatures2d module)" << endl;
+    // Grayscale for detection once per image; keep the color image for display
+    if (stages.grayImage != imageGeneration) {
+        stages.colorImage = srcImage.clone();
+        if (srcImage.channels() == 3) {
+            cvtColor(srcImage, stages.gray, COLOR_BGR2GRAY);
+        } else {
+            stages.gray = srcImage.clone();
+            cvtColor(stages.gray, stages.colorImage, COLOR_GRAY2BGR);
+        }
+        stages.grayImage = imageGeneration;
+        stages.pyramidKey.clear();
     }
-}
-
-void processImage(const Mat& img) {
-    Mat colorImage = img.clone();  // Keep color version for display
     
-    // Convert to grayscale for detection (SIFT works on grayscale)
-    if (img.channels() == 3) {
-        cvtColor(img, srcImage, COLOR_BGR2GRAY);
-    } else {
-        srcImage = img.clone();
-        cvtColor(srcImage, colorImage, COLOR_GRAY2BGR);  // Convert to color for display
+    // Steps 1-2: Gaussian and DoG pyramid, rebuilt only for a new image,
+    // octave layer count or sigma
+    int64 start = getTickCount();
+    int pyramidArgs[] = { imageGeneration, nOctaveLayers, cvRound(actualSigma * 10) };
+    vector<int> pyramidKey(pyramidArgs, pyramidArgs + 3);
+    bool newPyramid = stages.pyramidKey != pyramidKey;
+    if (newPyramid) {
+        buildDoGPyramid(stages.gray, stages.pyramid, nOctaveLayers, actualSigma);
+        stages.pyramidKey = pyramidKey;
+        stages.candidateFloor = -1;
+    }
+    double pyramidMs = (getTickCount() - start) * 1000.0 / getTickFrequency();
+    
+    // Step 3: local extrema, refined and oriented. Camera frames are never
+    // re-filtered, so they are only scanned down to the current contrast
+    start = getTickCount();
+    bool rescanned = stages.candidateFloor < 0 || actualContrastThresh < stages.candidateFloor;
+    if (rescanned) {
+        stages.candidateFloor = fromCamera ? actualContrastThresh : MIN_CONTRAST;
+        findDoGCandidates(stages.pyramid, stages.candidateFloor, stages.candidates);
     }
+    double candidateMs = (getTickCount() - start) * 1000.0 / getTickFrequency();
+    
+    // Step 4: contrast and edge tests on the cached candidates
+    start = getTickCount();
+    vector<KeyPoint> keypoints;
+    filterDoGCandidates(stages.candidates, nOctaveLayers, actualContrastThresh, edgeThreshold,
+                        keypoints, nFeatures);
+    double filterMs = (getTickCount() - start) * 1000.0 / getTickFrequency();
+    
+    // Draw detected keypoints on a fresh copy of the color image
+    resultImage = stages.colorImage.clone();
+    drawKeypoints(resultImage, keypoints, resultImage, 
+                  Scalar(0, 0, 255), 
+                  DrawMatchesFlags::DRAW_RICH_KEYPOINTS);
+    
+    // Display keypoint count and info
+    string info = "DoG Keypoints: " + to_string(keypoints.size());
+    putText(resultImage, info, Point(10, 30), FONT_HERSHEY_SIMPLEX, 
+            0.7, Scalar(0, 255, 0), 2);
     
-    // Store color image globally for drawing
-    resultImage = colorImage.clone();
+    // Display parameters
+    string params_str = "Features:" + to_string(nFeatures) + 
+                       " Octaves:" + to_string(nOctaveLayers) +
+                       " Contrast:" + to_string(actualContrastThresh).substr(0, 4);
+    putText(resultImage, params_str, Point(10, 60), FONT_HERSHEY_SIMPLEX, 
+            0.5, Scalar(255, 255, 0), 1);
+    
+    string filters = "Edge:" + to_string(edgeThreshold) + " " +
+                    "Sigma:" + to_string(actualSigma).substr(0, 3);
+    putText(resultImage, filters, Point(10, 85), FONT_HERSHEY_SIMPLEX, 
+            0.5, Scalar(255, 255, 0), 1);
+    
+    // Time per stage; cached stages show as such
+    string timing = "Pyramid:" + (newPyramid ? to_string(cvRound(pyramidMs)) + "ms" : string("cached")) +
+                    " Extrema:" + (rescanned ? to_string(cvRound(candidateMs)) + "ms" : string("cached")) +
+                    " Filter:" + to_string(filterMs).substr(0, 4) + "ms" +
+                    " (" + to_string(stages.candidates.size()) + " candidates)";
+    putText(resultImage, timing, Point(10, 110), FONT_HERSHEY_SIMPLEX, 
+            0.5, Scalar(255, 255, 0), 1);
+    
+    imshow(windowName, resultImage);
+}
+
+void processImage(const Mat& img) {
+    srcImage = img.clone();
+    imageGeneration++;
     
-    // Perform DoG detection
+    // Perform DoG detection (will handle grayscale conversion internally)
     dogDetection(0, 0);
 }
 
@@ -7,6 +7,11 @@
 #include <string>
 #include <vector>
 
+#include "harris_core.hpp"
+#include "harris_kernel.hpp"
+#include "keypoint_select.hpp"
+#include "pair_extract.hpp"
+
 using namespace cv;
 using namespace cv::xfeatures2d;
 using namespace std;
@@ -70,144 +75,29 @@ void matchFeatures(int, void*) {
         
         double k = (harrisK + 1) / 100.0;
         
-        // === IMAGE 1: Manual Harris Detection ===
-        
-        // Step 1: Compute gradients
-        Mat Ix1, Iy1;
-        Sobel(gray1, Ix1, CV_32F, 1, 0, actualApertureSize);
-        Sobel(gray1, Iy1, CV_32F, 0, 1, actualApertureSize);
-        
-        // Step 2: Compute gradient products
-        Mat Ixx1, Iyy1, Ixy1;
-        multiply(Ix1, Ix1, Ixx1);
-        multiply(Iy1, Iy1, Iyy1);
-        multiply(Ix1, Iy1, Ixy1);
-        
-        // Step 3: Apply Gaussian smoothing (structure tensor)
-        Mat Sxx1, Syy1, Sxy1;
-        int kernelSize = actualBlockSize * 2 + 1;
-        GaussianBlur(Ixx1, Sxx1, Size(kernelSize, kernelSize), 0);
-        GaussianBlur(Iyy1, Syy1, Size(kernelSize, kernelSize), 0);
-        GaussianBlur(Ixy1, Sxy1, Size(kernelSize, kernelSize), 0);
-        
-        // Step 4: Compute Harris response
-        Mat harris1(gray1.size(), CV_32F);
-        for (int i = 0; i < gray1.rows; i++) {
-            for (int j = 0; j < gray1.cols; j++) {
-                float sxx = Sxx1.at<float>(i, j);
-                float syy = Syy1.at<float>(i, j);
-                float sxy = Sxy1.at<float>(i, j);
-                
-                float det = sxx * syy - sxy * sxy;
-                float trace = sxx + syy;
-                float response = det - k * trace * trace;
-                
-                harris1.at<float>(i, j) = response;
-            }
-        }
-        
-        // Normalize
-        Mat harrisNorm1;
-        normalize(harris1, harrisNorm1, 0, 255, NORM_MINMAX, CV_32FC1);
-        
-        // === IMAGE 2: Manual Harris Detection ===
-        
-        // Step 1: Compute gradients
-        Mat Ix2, Iy2;
-        Sobel(gray2, Ix2, CV_32F, 1, 0, actualApertureSize);
-        Sobel(gray2, Iy2, CV_32F, 0, 1, actualApertureSize);
-        
-        // Step 2: Compute gradient products
-        Mat Ixx2, Iyy2, Ixy2;
-        multiply(Ix2, Ix2, Ixx2);
-        multiply(Iy2, Iy2, Iyy2);
-        multiply(Ix2, Iy2, Ixy2);
-        
-        // Step 3: Apply Gaussian smoothing
-        Mat Sxx2, Syy2, Sxy2;
-        GaussianBlur(Ixx2, Sxx2, Size(kernelSize, kernelSize), 0);
-        GaussianBlur(Iyy2, Syy2, Size(kernelSize, kernelSize), 0);
-        GaussianBlur(Ixy2, Sxy2, Size(kernelSize, kernelSize), 0);
-        
-        // Step 4: Compute Harris response
-        Mat harris2(gray2.size(), CV_32F);
-        for (int i = 0; i < gray2.rows; i++) {
-            for (int j = 0; j < gray2.cols; j++) {
-                float sxx = Sxx2.at<float>(i, j);
-                float syy = Syy2.at<float>(i, j);
-                float sxy = Sxy2.at<float>(i, j);
-                
-                float det = sxx * syy - sxy * sxy;
-                float trace = sxx + syy;
-                float response = det - k * trace * trace;
-                
-                harris2.at<float>(i, j) = response;
-            }
-        }
-        
-        // Normalize
-        Mat harrisNorm2;
-        normalize(harris2, harrisNorm2, 0, 255, NORM_MINMAX, CV_32FC1);
+        // 1-2. DETECT AND DESCRIBE both images at once (pair_extract.hpp).
+        // Per image: Steps 1-4 (Sobel gradients -> products -> Gaussian-
+        // weighted structure tensor -> R = det(M) - k * trace(M)^2) on the
+        // kernel specialized for this aperture/block pair, then 5x5 local
+        // maxima above the threshold (0..255 normalized scale), strongest
+        // first and capped to keep the matcher fast, then SIFT descriptors
+        // at those corners.
+        const int nmsRadius = 2;
+        const int maxKeypoints = 2000;
+        Mat descriptors1, descriptors2;
+        double extractMs = extractPair(gray1, gray2, keypoints1, keypoints2, descriptors1, descriptors2,
+            [&](const Mat& gray, vector<KeyPoint>& keypoints, Mat& descriptors) {
+                Mat harris;
+                computeHarrisAuto(gray, harris, actualBlockSize, actualApertureSize, k);
+                selectKeypointsNMS(harris, normalizedThreshold(harris, harrisThreshold),
+                                   nmsRadius, maxKeypoints, keypoints);
+                if (!keypoints.empty()) SIFT::create()->compute(gray, keypoints, descriptors);
+            });
         
         // ========== END MANUAL HARRIS IMPLEMENTATION ==========
         
-        // Convert corners to KeyPoints (OPTIMIZED - use threshold instead of nested loops)
-        keypoints1.clear();
-        keypoints2.clear();
-        
-        // Image 1 corners - find and sort by strength
-        Mat cornerMask1;
-        threshold(harrisNorm1, cornerMask1, harrisThreshold, 255, THRESH_BINARY);
-        cornerMask1.convertTo(cornerMask1, CV_8U);
-        
-        vector<Point> corners1;
-        findNonZero(cornerMask1, corners1);
-        
-        // Sort corners by Harris response strength (strongest first)
-        vector<pair<float, Point>> cornersWithStrength1;
-        for (size_t i = 0; i < corners1.size(); i++) {
-            float strength = harrisNorm1.at<float>(corners1[i]);
-            cornersWithStrength1.push_back(make_pair(strength, corners1[i]));
-        }
-        sort(cornersWithStrength1.begin(), cornersWithStrength1.end(),
-             [](const pair<float, Point>& a, const pair<float, Point>& b) {
-                 return a.first > b.first;  // Sort descending by strength
-             });
-        
-        // Keep only top N strongest corners (limit to 2000 to prevent matcher overflow)
-        int maxKeypoints = 2000;
-        for (size_t i = 0; i < min((size_t)maxKeypoints, cornersWithStrength1.size()); i++) {
-            keypoints1.push_back(KeyPoint(cornersWithStrength1[i].second.x, 
-                                         cornersWithStrength1[i].second.y, 1));
-        }
-        
-        // Image 2 corners - find and sort by strength
-        Mat cornerMask2;
-        threshold(harrisNorm2, cornerMask2, harrisThreshold, 255, THRESH_BINARY);
-        cornerMask2.convertTo(cornerMask2, CV_8U);
-        
-        vector<Point> corners2;
-        findNonZero(cornerMask2, corners2);
-        
-        // Sort corners by Harris response strength
-        vector<pair<float, Point>> cornersWithStrength2;
-        for (size_t i = 0; i < corners2.size(); i++) {
-            float strength = harrisNorm2.at<float>(corners2[i]);
-            cornersWithStrength2.push_back(make_pair(strength, corners2[i]));
-        }
-        sort(cornersWithStrength2.begin(), cornersWithStrength2.end(),
-             [](const pair<float, Point>& a, const pair<float, Point>& b) {
-                 return a.first > b.first;
-             });
-        
-        // Keep only top N strongest corners
-        for (size_t i = 0; i < min((size_t)maxKeypoints, cornersWithStrength2.size()); i++) {
-            keypoints2.push_back(KeyPoint(cornersWithStrength2[i].second.x,
-                                         cornersWithStrength2[i].second.y, 1));
-        }
-        
         cout << "Harris corners detected: " << keypoints1.size() << " (image1), " 
-             << keypoints2.size() << " (image2)" << endl;
+             << keypoints2.size() << " (image2) in " << extractMs << " ms (both images)" << endl;
         
         if (keypoints1.empty() || keypoints2.empty()) {
             cout << "No keypoints detected. Adjust Harris threshold." << endl;
@@ -215,13 +105,6 @@ void matchFeatures(int, void*) {
             return;
         }
         
-        // 2. COMPUTE SIFT DESCRIPTORS at Harris corners
-        Ptr<SIFT> sift = SIFT::create();
-        Mat descriptors1, descriptors2;
-        
-        sift->compute(gray1, keypoints1, descriptors1);
-        sift->compute(gray2, keypoints2, descriptors2);
-        
         if (descriptors1.empty() || descriptors2.empty()) {
             cout << "No descriptors computed." << endl;
             resultImage = Mat();
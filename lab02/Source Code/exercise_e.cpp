@@ -7,6 +7,8 @@
 #include <string>
 #include <vector>
 
+#include "pair_extract.hpp"
+
 using namespace cv;
 using namespace cv::xfeatures2d;
 using namespace std;
@@ -68,25 +70,23 @@ void matchFeatures(int, void*) {
         
         // ========== DOG + SIFT DETECTION AND MATCHING ==========
         
-        // Create SIFT detector (SIFT uses DoG internally for detection)
-        Ptr<SIFT> sift = SIFT::create(
-            nFeatures,              // nfeatures
-            nOctaveLayers,          // nOctaveLayers
-            actualContrastThresh,   // contrastThreshold
-            edgeThreshold,          // edgeThreshold
-            1.6                     // sigma
-        );
-        
-        // Detect keypoints and compute descriptors for image 1
-        Mat descriptors1;
-        sift->detectAndCompute(gray1, noArray(), keypoints1, descriptors1);
-        
-        // Detect keypoints and compute descriptors for image 2
-        Mat descriptors2;
-        sift->detectAndCompute(gray2, noArray(), keypoints2, descriptors2);
+        // Detect keypoints and compute descriptors for both images at once,
+        // one SIFT instance each (SIFT uses DoG internally for detection)
+        Mat descriptors1, descriptors2;
+        double extractMs = extractPair(gray1, gray2, keypoints1, keypoints2, descriptors1, descriptors2,
+            [&](const Mat& gray, vector<KeyPoint>& keypoints, Mat& descriptors) {
+                Ptr<SIFT> sift = SIFT::create(
+                    nFeatures,              // nfeatures
+                    nOctaveLayers,          // nOctaveLayers
+                    actualContrastThresh,   // contrastThreshold
+                    edgeThreshold,          // edgeThreshold
+                    1.6                     // sigma
+                );
+                sift->detectAndCompute(gray, noArray(), keypoints, descriptors);
+            });
         
         cout << "DoG keypoints detected: " << keypoints1.size() << " (image1), " 
-             << keypoints2.size() << " (image2)" << endl;
+             << keypoints2.size() << " (image2) in " << extractMs << " ms (both images)" << endl;
         
         if (keypoints1.empty() || keypoints2.empty()) {
             cout << "No keypoints detected. Adjust parameters." << endl;
@@ -7,6 +7,8 @@
 #include <string>
 #include <vector>
 
+#include "pair_extract.hpp"
+
 using namespace cv;
 using namespace cv::xfeatures2d;
 using namespace std;
@@ -77,15 +79,18 @@ void matchFeatures(int, void*) {
         params.filterByInertia = true;
         params.minInertiaRatio = minInertia / 100.0f;
         
-        // Create detector
-        Ptr<SimpleBlobDetector> detector = SimpleBlobDetector::create(params);
-        
-        // Detect blobs in both images
-        detector->detect(gray1, keypoints1);
-        detector->detect(gray2, keypoints2);
+        // Detect blobs and compute SIFT descriptors at the blob locations for
+        // both images at once; each side creates its own detector, since
+        // SimpleBlobDetector keeps per-call state
+        Mat descriptors1, descriptors2;
+        double extractMs = extractPair(gray1, gray2, keypoints1, keypoints2, descriptors1, descriptors2,
+            [&](const Mat& gray, vector<KeyPoint>& keypoints, Mat& descriptors) {
+                SimpleBlobDetector::create(params)->detect(gray, keypoints);
+                if (!keypoints.empty()) SIFT::create()->compute(gray, keypoints, descriptors);
+            });
         
         cout << "Blobs detected: " << keypoints1.size() << " (image1), " 
-             << keypoints2.size() << " (image2)" << endl;
+             << keypoints2.size() << " (image2) in " << extractMs << " ms (both images)" << endl;
         
         if (keypoints1.empty() || keypoints2.empty()) {
             cout << "No blobs detected. Adjust parameters." << endl;
@@ -93,13 +98,6 @@ void matchFeatures(int, void*) {
             return;
         }
         
-        // Compute SIFT descriptors at blob locations
-        Ptr<SIFT> sift = SIFT::create();
-        Mat descriptors1, descriptors2;
-        
-        sift->compute(gray1, keypoints1, descriptors1);
-        sift->compute(gray2, keypoints2, descriptors2);
-        
         if (descriptors1.empty() || descriptors2.empty()) {
             cout << "No descriptors computed." << endl;
             resultImage = Mat();
@@ -6,6 +6,12 @@
 #include <string>
 #include <vector>
 
+#include "harris_core.hpp"
+#include "harris_kernel.hpp"
+#include "keypoint_select.hpp"
+#include "lbp_descriptor.hpp"
+#include "pair_extract.hpp"
+
 using namespace cv;
 using namespace std;
 
@@ -29,58 +35,6 @@ Mat resultImage;
 vector<KeyPoint> keypoints1, keypoints2;
 const string windowName = "Harris + LBP Matching";
 
-// Compute LBP descriptor for a keypoint region
-Mat computeLBPDescriptor(const Mat& gray, Point2f center, int radius) {
-    int patchSize = 40;  // Larger patch for better description
-    int x = cvRound(center.x);
-    int y = cvRound(center.y);
-    
-    // Extract patch
-    int x1 = max(0, x - patchSize/2);
-    int y1 = max(0, y - patchSize/2);
-    int x2 = min(gray.cols, x + patchSize/2);
-    int y2 = min(gray.rows, y + patchSize/2);
-    
-    if (x2 <= x1 + 5 || y2 <= y1 + 5) return Mat();
-    
-    Rect roi(x1, y1, x2-x1, y2-y1);
-    Mat patch = gray(roi);
-    
-    // Compute LBP for the patch
-    Mat lbp = Mat::zeros(patch.size(), CV_8U);
-    for (int i = 1; i < patch.rows - 1; i++) {
-        for (int j = 1; j < patch.cols - 1; j++) {
-            uchar center = patch.at<uchar>(i, j);
-            uchar code = 0;
-            code |= (patch.at<uchar>(i-1, j) >= center) << 7;
-            code |= (patch.at<uchar>(i-1, j+1) >= center) << 6;
-            code |= (patch.at<uchar>(i, j+1) >= center) << 5;
-            code |= (patch.at<uchar>(i+1, j+1) >= center) << 4;
-            code |= (patch.at<uchar>(i+1, j) >= center) << 3;
-            code |= (patch.at<uchar>(i+1, j-1) >= center) << 2;
-            code |= (patch.at<uchar>(i, j-1) >= center) << 1;
-            code |= (patch.at<uchar>(i-1, j-1) >= center) << 0;
-            lbp.at<uchar>(i, j) = code;
-        }
-    }
-    
-    // Create histogram (256 bins for full LBP)
-    int histSize = 256;
-    float range[] = {0, 256};
-    const float* histRange = {range};
-    Mat hist;
-    calcHist(&lbp, 1, 0, Mat(), hist, 1, &histSize, &histRange);
-    
-    // Add small value to avoid division by zero
-    hist += 1e-7;
-    
-    // Normalize to sum = 1
-    double sum = cv::sum(hist)[0];
-    hist /= sum;
-    
-    return hist.reshape(1, 1);  // Row vector
-}
-
 void matchFeatures(int, void*) {
     if (gray1.empty() || gray2.empty()) return;
     
@@ -90,84 +44,35 @@ void matchFeatures(int, void*) {
         if (actualApertureSize > 7) actualApertureSize = 7;
         double k = (harrisK + 1) / 100.0;
         
+        // Both images at once (pair_extract.hpp), each running:
         // MANUAL HARRIS DETECTION
-        Mat Ix1, Iy1, Ix2, Iy2;
-        Sobel(gray1, Ix1, CV_32F, 1, 0, actualApertureSize);
-        Sobel(gray1, Iy1, CV_32F, 0, 1, actualApertureSize);
-        Sobel(gray2, Ix2, CV_32F, 1, 0, actualApertureSize);
-        Sobel(gray2, Iy2, CV_32F, 0, 1, actualApertureSize);
-        
-        Mat Ixx1, Iyy1, Ixy1, Ixx2, Iyy2, Ixy2;
-        multiply(Ix1, Ix1, Ixx1);
-        multiply(Iy1, Iy1, Iyy1);
-        multiply(Ix1, Iy1, Ixy1);
-        multiply(Ix2, Ix2, Ixx2);
-        multiply(Iy2, Iy2, Iyy2);
-        multiply(Ix2, Iy2, Ixy2);
-        
-        int kernelSize = actualBlockSize * 2 + 1;
-        Mat Sxx1, Syy1, Sxy1, Sxx2, Syy2, Sxy2;
-        GaussianBlur(Ixx1, Sxx1, Size(kernelSize, kernelSize), 0);
-        GaussianBlur(Iyy1, Syy1, Size(kernelSize, kernelSize), 0);
-        GaussianBlur(Ixy1, Sxy1, Size(kernelSize, kernelSize), 0);
-        GaussianBlur(Ixx2, Sxx2, Size(kernelSize, kernelSize), 0);
-        GaussianBlur(Iyy2, Syy2, Size(kernelSize, kernelSize), 0);
-        GaussianBlur(Ixy2, Sxy2, Size(kernelSize, kernelSize), 0);
-        
-        Mat harris1(gray1.size(), CV_32F), harris2(gray2.size(), CV_32F);
-        for (int i = 0; i < gray1.rows; i++) {
-            for (int j = 0; j < gray1.cols; j++) {
-                float sxx = Sxx1.at<float>(i, j), syy = Syy1.at<float>(i, j), sxy = Sxy1.at<float>(i, j);
-                harris1.at<float>(i, j) = sxx * syy - sxy * sxy - k * (sxx + syy) * (sxx + syy);
-            }
-        }
-        for (int i = 0; i < gray2.rows; i++) {
-            for (int j = 0; j < gray2.cols; j++) {
-                float sxx = Sxx2.at<float>(i, j), syy = Syy2.at<float>(i, j), sxy = Sxy2.at<float>(i, j);
-                harris2.at<float>(i, j) = sxx * syy - sxy * sxy - k * (sxx + syy) * (sxx + syy);
-            }
-        }
-        
-        Mat harrisNorm1, harrisNorm2;
-        normalize(harris1, harrisNorm1, 0, 255, NORM_MINMAX);
-        normalize(harris2, harrisNorm2, 0, 255, NORM_MINMAX);
-        
-        // Extract keypoints
-        keypoints1.clear(); keypoints2.clear();
-        Mat mask1, mask2;
-        threshold(harrisNorm1, mask1, harrisThreshold, 255, THRESH_BINARY);
-        threshold(harrisNorm2, mask2, harrisThreshold, 255, THRESH_BINARY);
-        mask1.convertTo(mask1, CV_8U);
-        mask2.convertTo(mask2, CV_8U);
-        
-        vector<Point> corners1, corners2;
-        findNonZero(mask1, corners1);
-        findNonZero(mask2, corners2);
-        
-        // Limit to top 500 corners
-        int maxCorners = 500;
-        for (size_t i = 0; i < min((size_t)maxCorners, corners1.size()); i++)
-            keypoints1.push_back(KeyPoint(corners1[i].x, corners1[i].y, 1));
-        for (size_t i = 0; i < min((size_t)maxCorners, corners2.size()); i++)
-            keypoints2.push_back(KeyPoint(corners2[i].x, corners2[i].y, 1));
+        // Sobel -> products -> Gaussian window -> response, using the kernel
+        // specialized for this aperture/block pair (harris_kernel.hpp)
+        // Keypoints: pixels above the user threshold (0..255 scale),
+        // tightened by a one-pass response histogram and then cut to exactly
+        // the 500 strongest by a bounded heap (not raster order), so the LBP
+        // matching cost stays bounded on busy images
+        // LBP descriptors at the keypoints
+        const int maxCorners = 500;
+        Mat descriptors1, descriptors2;
+        double extractMs = extractPair(gray1, gray2, keypoints1, keypoints2, descriptors1, descriptors2,
+            [&](const Mat& gray, vector<KeyPoint>& keypoints, Mat& descriptors) {
+                Mat harris;
+                computeHarrisAuto(gray, harris, actualBlockSize, actualApertureSize, k);
+                
+                selectKeypointsNMS(harris, max(normalizedThreshold(harris, harrisThreshold),
+                                               countThreshold(harris, maxCorners)), 0, maxCorners, keypoints);
+                
+                Mat codes;
+                computeLBPCodes(gray, codes);
+                computeLBPDescriptors(codes, keypoints, descriptors);
+            });
         
-        cout << "Harris corners: " << keypoints1.size() << " (img1), " << keypoints2.size() << " (img2)" << endl;
+        cout << "Harris corners: " << keypoints1.size() << " (img1), " << keypoints2.size() << " (img2) in "
+             << extractMs << " ms (both images)" << endl;
         
         if (keypoints1.empty() || keypoints2.empty()) return;
         
-        // Compute LBP descriptors
-        Mat descriptors1(keypoints1.size(), 256, CV_32F);
-        Mat descriptors2(keypoints2.size(), 256, CV_32F);
-        
-        for (size_t i = 0; i < keypoints1.size(); i++) {
-            Mat desc = computeLBPDescriptor(gray1, keypoints1[i].pt, lbpRadius + 1);
-            if (!desc.empty()) desc.copyTo(descriptors1.row(i));
-        }
-        for (size_t i = 0; i < keypoints2.size(); i++) {
-            Mat desc = computeLBPDescriptor(gray2, keypoints2[i].pt, lbpRadius + 1);
-            if (!desc.empty()) desc.copyTo(descriptors2.row(i));
-        }
-        
         // Match using histogram intersection (better for LBP histograms)
         vector<DMatch> goodMatches;
         for (size_t i = 0; i < keypoints1.size(); i++) {
@@ -5,6 +5,9 @@
 #include <opencv2/imgproc.hpp>
 #include <iostream>
 
+#include "lbp_descriptor.hpp"
+#include "pair_extract.hpp"
+
 using namespace cv;
 using namespace cv::xfeatures2d;
 using namespace std;
@@ -22,41 +25,6 @@ Mat img1, img2, gray1, gray2, resultImage;
 vector<KeyPoint> keypoints1, keypoints2;
 const string windowName = "Blob + LBP Matching";
 
-Mat computeLBPDescriptor(const Mat& gray, Point2f center, int radius) {
-    int patchSize = 40;
-    int x = cvRound(center.x), y = cvRound(center.y);
-    int x1 = max(0, x - patchSize/2), y1 = max(0, y - patchSize/2);
-    int x2 = min(gray.cols, x + patchSize/2), y2 = min(gray.rows, y + patchSize/2);
-    if (x2 <= x1 + 5 || y2 <= y1 + 5) return Mat();
-    
-    Mat patch = gray(Rect(x1, y1, x2-x1, y2-y1));
-    Mat lbp = Mat::zeros(patch.size(), CV_8U);
-    
-    for (int i = 1; i < patch.rows - 1; i++) {
-        for (int j = 1; j < patch.cols - 1; j++) {
-            uchar c = patch.at<uchar>(i, j), code = 0;
-            code |= (patch.at<uchar>(i-1,j) >= c) << 7;
-            code |= (patch.at<uchar>(i-1,j+1) >= c) << 6;
-            code |= (patch.at<uchar>(i,j+1) >= c) << 5;
-            code |= (patch.at<uchar>(i+1,j+1) >= c) << 4;
-            code |= (patch.at<uchar>(i+1,j) >= c) << 3;
-            code |= (patch.at<uchar>(i+1,j-1) >= c) << 2;
-            code |= (patch.at<uchar>(i,j-1) >= c) << 1;
-            code |= (patch.at<uchar>(i-1,j-1) >= c) << 0;
-            lbp.at<uchar>(i,j) = code;
-        }
-    }
-    
-    int histSize = 256;
-    float range[] = {0, 256};
-    const float* histRange = {range};
-    Mat hist;
-    calcHist(&lbp, 1, 0, Mat(), hist, 1, &histSize, &histRange);
-    hist += 1e-7;
-    hist /= cv::sum(hist)[0];
-    return hist.reshape(1, 1);
-}
-
 void matchFeatures(int, void*) {
     if (gray1.empty() || gray2.empty()) return;
     
@@ -75,26 +43,21 @@ void matchFeatures(int, void*) {
         params.filterByInertia = true;
         params.minInertiaRatio = minInertia / 100.0f;
         
-        Ptr<SimpleBlobDetector> detector = SimpleBlobDetector::create(params);
-        detector->detect(gray1, keypoints1);
-        detector->detect(gray2, keypoints2);
+        // Blobs and LBP descriptors for both images at once, one detector each
+        Mat descriptors1, descriptors2;
+        double extractMs = extractPair(gray1, gray2, keypoints1, keypoints2, descriptors1, descriptors2,
+            [&](const Mat& gray, vector<KeyPoint>& keypoints, Mat& descriptors) {
+                SimpleBlobDetector::create(params)->detect(gray, keypoints);
+                
+                Mat codes;
+                computeLBPCodes(gray, codes);
+                computeLBPDescriptors(codes, keypoints, descriptors);
+            });
         
-        cout << "Blob keypoints: " << keypoints1.size() << " (img1), " << keypoints2.size() << " (img2)" << endl;
+        cout << "Blob keypoints: " << keypoints1.size() << " (img1), " << keypoints2.size() << " (img2) in "
+             << extractMs << " ms (both images)" << endl;
         if (keypoints1.empty() || keypoints2.empty()) return;
         
-        // Compute LBP descriptors
-        Mat descriptors1(keypoints1.size(), 256, CV_32F);
-        Mat descriptors2(keypoints2.size(), 256, CV_32F);
-        
-        for (size_t i = 0; i < keypoints1.size(); i++) {
-            Mat desc = computeLBPDescriptor(gray1, keypoints1[i].pt, lbpRadius + 1);
-            if (!desc.empty()) desc.copyTo(descriptors1.row(i));
-        }
-        for (size_t i = 0; i < keypoints2.size(); i++) {
-            Mat desc = computeLBPDescriptor(gray2, keypoints2[i].pt, lbpRadius + 1);
-            if (!desc.empty()) desc.copyTo(descriptors2.row(i));
-        }
-        
         // Match using chi-square distance
         vector<DMatch> goodMatches;
         for (size_t i = 0; i < keypoints1.size(); i++) {
@@ -0,0 +1,158 @@
+#ifndef FAST_HESSIAN_HPP
+#define FAST_HESSIAN_HPP
+
+#include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <vector>
+
+// SURF-style Fast-Hessian blob detector ("hessian" in cvlab/cvlab_auto).
+//
+// The determinant of the Hessian is approximated with box filters on one
+// integral image: Dxx, Dyy and Dxy are two to four box sums each, so a
+// response costs the same at every scale. Octave o holds 4 layers with
+// filter sizes 3 * (2^(o+1) * (l+1) + 1) (9, 15, 21, 27 / 15, 27, 39, 51 / ...)
+// sampled every 2^o pixels. Keypoints are 3x3x3 maxima of the response over
+// x, y and scale above hessianThreshold, refined by a parabola per axis.
+// KeyPoint::size is the interpolated filter size, octave the octave and
+// class_id the sign of the Laplacian (+1 dark blob on light, -1 light on dark).
+
+struct HessianLayer {
+    int filterSize, step;
+    cv::Mat det;        // CV_32F, layer resolution (image size / step)
+    cv::Mat trace;      // CV_32F, Dxx + Dyy
+};
+
+// Sum over rows [row, row + height) x cols [col, col + width), clipped to
+// the image; `sum` is the (H+1)x(W+1) cv::integral output
+template<typename T>
+inline double boxSum(const cv::Mat& sum, int row, int col, int height, int width) {
+    int r0 = std::min(std::max(row, 0), sum.rows - 1), r1 = std::min(std::max(row + height, 0), sum.rows - 1);
+    int c0 = std::min(std::max(col, 0), sum.cols - 1), c1 = std::min(std::max(col + width, 0), sum.cols - 1);
+    const T* top = sum.ptr<T>(r0);
+    const T* bottom = sum.ptr<T>(r1);
+    return (double)bottom[c1] - (double)bottom[c0] - (double)top[c1] + (double)top[c0];
+}
+
+template<typename T>
+inline void fastHessianLayer(const cv::Mat& sum, HessianLayer& layer) {
+    const int w = layer.filterSize, step = layer.step;
+    const int lobe = w / 3, border = (w - 1) / 2;
+    const double norm = 1.0 / ((double)w * w);
+    const int rows = (sum.rows - 1) / step, cols = (sum.cols - 1) / step;
+    layer.det.create(rows, cols, CV_32F);
+    layer.trace.create(rows, cols, CV_32F);
+
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& range) {
+        for (int r = range.start; r < range.end; r++) {
+            float* det = layer.det.ptr<float>(r);
+            float* trace = layer.trace.ptr<float>(r);
+            const int y = r * step;
+            for (int c = 0; c < cols; c++) {
+                const int x = c * step;
+                double dxx = boxSum<T>(sum, y - lobe + 1, x - border, 2 * lobe - 1, w)
+                           - 3 * boxSum<T>(sum, y - lobe + 1, x - lobe / 2, 2 * lobe - 1, lobe);
+                double dyy = boxSum<T>(sum, y - border, x - lobe + 1, w, 2 * lobe - 1)
+                           - 3 * boxSum<T>(sum, y - lobe / 2, x - lobe + 1, lobe, 2 * lobe - 1);
+                double dxy = boxSum<T>(sum, y - lobe, x + 1, lobe, lobe)
+                           + boxSum<T>(sum, y + 1, x - lobe, lobe, lobe)
+                           - boxSum<T>(sum, y - lobe, x - lobe, lobe, lobe)
+                           - boxSum<T>(sum, y + 1, x + 1, lobe, lobe);
+                dxx *= norm; dyy *= norm; dxy *= norm;
+                // 0.9 relative weight of the box Dxy (Bay et al.)
+                det[c] = (float)(dxx * dyy - 0.81 * dxy * dxy);
+                trace[c] = (float)(dxx + dyy);
+            }
+        }
+    });
+}
+
+// All layers of nOctaves octaves (4 layers each); layers[o * 4 + l]
+inline void buildFastHessianLayers(const cv::Mat& gray, std::vector<HessianLayer>& layers, int nOctaves = 4) {
+    CV_Assert(gray.type() == CV_8UC1);
+    // 32-bit sums are exact while the total fits; huge images fall back to double
+    const bool exact32 = gray.total() * 255.0 < INT_MAX;
+    cv::Mat sum;
+    cv::integral(gray, sum, exact32 ? CV_32S : CV_64F);
+
+    layers.clear();
+    for (int o = 0; o < nOctaves; o++) {
+        const int step = 1 << o;
+        if (gray.rows / step < 3 || gray.cols / step < 3) break;
+        for (int l = 0; l < 4; l++) {
+            HessianLayer layer;
+            layer.filterSize = 3 * ((1 << (o + 1)) * (l + 1) + 1);
+            layer.step = step;
+            if (exact32) fastHessianLayer<int>(sum, layer);
+            else fastHessianLayer<double>(sum, layer);
+            layers.push_back(layer);
+        }
+    }
+}
+
+// Vertex offset of the parabola through (-1, a), (0, b), (1, c), or 0 when
+// the three values are not strictly peaked
+inline float parabolaOffset(float a, float b, float c) {
+    float curvature = a - 2 * b + c;
+    return curvature < 0 ? 0.5f * (a - c) / curvature : 0.f;
+}
+
+inline void detectFastHessian(const cv::Mat& gray, std::vector<cv::KeyPoint>& keypoints,
+                              double hessianThreshold = 100, int nOctaves = 4) {
+    std::vector<HessianLayer> layers;
+    buildFastHessianLayers(gray, layers, nOctaves);
+    keypoints.clear();
+
+    for (size_t base = 0; base + 3 < layers.size(); base += 4) {
+        const int step = layers[base].step;
+        const int octave = (int)base / 4;
+        // Skip where the largest filter of the octave leaves the image
+        const int margin = layers[base + 3].filterSize / 2 / step + 1;
+
+        for (int l = 1; l <= 2; l++) {
+            const cv::Mat& below = layers[base + l - 1].det;
+            const cv::Mat& here = layers[base + l].det;
+            const cv::Mat& above = layers[base + l + 1].det;
+            const int filterSize = layers[base + l].filterSize;
+            const int sizeStep = layers[base + l + 1].filterSize - filterSize;
+
+            for (int r = margin; r < here.rows - margin; r++) {
+                const float* row = here.ptr<float>(r);
+                for (int c = margin; c < here.cols - margin; c++) {
+                    const float v = row[c];
+                    if (v < hessianThreshold) continue;
+
+                    bool isMax = true;
+                    for (int dy = -1; dy <= 1 && isMax; dy++) {
+                        const float* b = below.ptr<float>(r + dy);
+                        const float* h = here.ptr<float>(r + dy);
+                        const float* a = above.ptr<float>(r + dy);
+                        for (int dx = -1; dx <= 1; dx++) {
+                            if (b[c + dx] >= v || a[c + dx] >= v || ((dx || dy) && h[c + dx] >= v)) {
+                                isMax = false;
+                                break;
+                            }
+                        }
+                    }
+                    if (!isMax) continue;
+
+                    // Sub-sample position and scale (strict maxima keep every
+                    // offset within half a sample)
+                    float ox = parabolaOffset(row[c - 1], v, row[c + 1]);
+                    float oy = parabolaOffset(here.at<float>(r - 1, c), v, here.at<float>(r + 1, c));
+                    float os = parabolaOffset(below.at<float>(r, c), v, above.at<float>(r, c));
+
+                    float trace = layers[base + l].trace.at<float>(r, c);
+                    keypoints.push_back(cv::KeyPoint(cv::Point2f((c + ox) * step, (r + oy) * step),
+                                                     filterSize + os * sizeStep, -1, v, octave,
+                                                     trace > 0 ? 1 : -1));
+                }
+            }
+        }
+    }
+}
+
+#endif // FAST_HESSIAN_HPP
@@ -0,0 +1,86 @@
+#ifndef FILTER_CASCADE_HPP
+#define FILTER_CASCADE_HPP
+
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Self-ordering cascade of pass/reject filters (exercise_b's blob shape
+// filters). A candidate passes only if every filter passes, so the order
+// does not change the result, only the cost: run() times each filter it
+// calls and counts its rejections, and reorder() sorts the filters by
+// expected cost per rejection (mean time / rejection rate), so cheap,
+// selective filters run first and expensive ones see few candidates.
+//
+// The statistics are halved on every reorder(), so the order follows
+// parameter changes (e.g. a trackbar making one filter stricter) within a
+// few calls instead of being dominated by old history.
+
+class FilterCascade {
+public:
+    explicit FilterCascade(const std::vector<std::string>& filterNames)
+        : names(filterNames), runs(names.size(), 0), rejects(names.size(), 0),
+          ticks(names.size(), 0), order(names.size()) {
+        for (size_t i = 0; i < order.size(); i++) order[i] = (int)i;
+    }
+
+    // check(filter) returns true when the candidate passes `filter`
+    template<typename Check>
+    bool run(Check check) {
+        for (size_t i = 0; i < order.size(); i++) {
+            const int f = order[i];
+            int64 start = cv::getTickCount();
+            bool pass = check(f);
+            ticks[f] += (double)(cv::getTickCount() - start);
+            runs[f] += 1;
+            if (!pass) {
+                rejects[f] += 1;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void reorder() {
+        std::vector<double> score(order.size());
+        for (size_t f = 0; f < order.size(); f++) {
+            // Laplace-smoothed rejection rate. A filter that was never
+            // reached scores 0 and moves to the front, so it gets measured.
+            double meanTicks = runs[f] > 0 ? ticks[f] / runs[f] : 0;
+            double rejectRate = (rejects[f] + 1) / (runs[f] + 2);
+            score[f] = meanTicks / rejectRate;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return score[a] < score[b]; });
+
+        for (size_t f = 0; f < order.size(); f++) {
+            runs[f] *= 0.5;
+            rejects[f] *= 0.5;
+            ticks[f] *= 0.5;
+        }
+    }
+
+    // Current order with each filter's mean cost and rejection rate over
+    // the decayed history, e.g. "area (0.1 us, 62% rejected) > ..."
+    std::string describe() const {
+        std::string text;
+        for (size_t i = 0; i < order.size(); i++) {
+            const int f = order[i];
+            double us = runs[f] > 0 ? ticks[f] / runs[f] * 1e6 / cv::getTickFrequency() : 0;
+            int rejected = runs[f] > 0 ? (int)(100 * rejects[f] / runs[f] + 0.5) : 0;
+            char stats[64];
+            std::snprintf(stats, sizeof(stats), " (%.1f us, %d%% rejected)", us, rejected);
+            if (i > 0) text += " > ";
+            text += names[f] + stats;
+        }
+        return text;
+    }
+
+private:
+    std::vector<std::string> names;
+    std::vector<double> runs, rejects, ticks;
+    std::vector<int> order;
+};
+
+#endif // FILTER_CASCADE_HPP
@@ -0,0 +1,188 @@
+#ifndef HARRIS_CORE_HPP
+#define HARRIS_CORE_HPP
+
+#include <opencv2/core.hpp>
+#include <opencv2/core/hal/intrin.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <vector>
+
+// Shared Harris building blocks used by exercise_a, exercise_d, exercise_g,
+// cvlab and cvlab_auto.
+
+// Harris response for one row of structure-tensor sums:
+// R = det(M) - k * trace(M)^2 with det(M) = Sxx*Syy - Sxy^2, trace(M) = Sxx + Syy.
+// Uses OpenCV universal intrinsics when available, scalar code for the tail.
+inline void harrisResponseRow(const float* sxx, const float* syy, const float* sxy,
+                              float* dst, int width, float k) {
+    int j = 0;
+#if CV_SIMD
+    const int lanes = cv::v_float32::nlanes;
+    cv::v_float32 vk = cv::vx_setall_f32(k);
+    for (; j <= width - lanes; j += lanes) {
+        cv::v_float32 a = cv::vx_load(sxx + j);
+        cv::v_float32 b = cv::vx_load(syy + j);
+        cv::v_float32 c = cv::vx_load(sxy + j);
+        cv::v_float32 trace = a + b;
+        cv::v_float32 det = a * b - c * c;
+        cv::v_store(dst + j, det - vk * trace * trace);
+    }
+#endif
+    for (; j < width; j++) {
+        float trace = sxx[j] + syy[j];
+        float det = sxx[j] * syy[j] - sxy[j] * sxy[j];
+        dst[j] = det - k * trace * trace;
+    }
+}
+
+// Harris response for whole CV_32F structure-tensor planes.
+// Continuous planes are processed as a single long row.
+inline void computeHarrisResponse(const cv::Mat& Sxx, const cv::Mat& Syy, const cv::Mat& Sxy,
+                                  cv::Mat& response, double k) {
+    CV_Assert(Sxx.type() == CV_32F && Syy.type() == CV_32F && Sxy.type() == CV_32F);
+    response.create(Sxx.size(), CV_32F);
+
+    int rows = Sxx.rows, cols = Sxx.cols;
+    if (Sxx.isContinuous() && Syy.isContinuous() && Sxy.isContinuous() && response.isContinuous()) {
+        cols *= rows;
+        rows = 1;
+    }
+
+    for (int i = 0; i < rows; i++) {
+        harrisResponseRow(Sxx.ptr<float>(i), Syy.ptr<float>(i), Sxy.ptr<float>(i),
+                          response.ptr<float>(i), cols, (float)k);
+    }
+}
+
+// Structure-tensor window used in Step 3
+enum HarrisWindow {
+    HARRIS_WINDOW_GAUSSIAN,  // GaussianBlur, (2*blockSize+1)^2 taps per pixel
+    HARRIS_WINDOW_BOX        // Box mean from integral images, O(1) per pixel
+};
+
+// Box-window Step 3: a single 3-channel CV_64F integral image of Ixx, Iyy,
+// Ixy, (rows+1) x (cols+1). It does not depend on blockSize, so callers that
+// vary only the window size or k can keep it.
+inline void harrisBoxIntegral(const cv::Mat& Ixx, const cv::Mat& Iyy, const cv::Mat& Ixy,
+                              cv::Mat& sums) {
+    cv::Mat planes[] = { Ixx, Iyy, Ixy };
+    cv::Mat products;
+    cv::merge(planes, 3, products);
+    cv::integral(products, sums, CV_64F);
+}
+
+// Box-window Step 4 from harrisBoxIntegral() sums: each pixel costs four
+// lookups per product regardless of blockSize. The window is
+// (2*blockSize+1)^2, clipped at the image border and divided by its area, so
+// values are on the same scale as the (normalized) Gaussian window.
+inline void harrisBoxResponse(const cv::Mat& sums, cv::Mat& response, int blockSize, double k) {
+    const int rows = sums.rows - 1, cols = sums.cols - 1;
+    response.create(rows, cols, CV_32F);
+    std::vector<float> sxx(cols), syy(cols), sxy(cols);
+
+    for (int y = 0; y < rows; y++) {
+        int y0 = std::max(0, y - blockSize), y1 = std::min(rows, y + blockSize + 1);
+        const double* top = sums.ptr<double>(y0);
+        const double* bottom = sums.ptr<double>(y1);
+
+        for (int x = 0; x < cols; x++) {
+            int x0 = std::max(0, x - blockSize), x1 = std::min(cols, x + blockSize + 1);
+            double inv = 1.0 / ((y1 - y0) * (x1 - x0));
+            const double *a = top + 3 * x0, *b = top + 3 * x1;
+            const double *c = bottom + 3 * x0, *d = bottom + 3 * x1;
+            sxx[x] = (float)((d[0] - c[0] - b[0] + a[0]) * inv);
+            syy[x] = (float)((d[1] - c[1] - b[1] + a[1]) * inv);
+            sxy[x] = (float)((d[2] - c[2] - b[2] + a[2]) * inv);
+        }
+        harrisResponseRow(&sxx[0], &syy[0], &sxy[0], response.ptr<float>(y), cols, (float)k);
+    }
+}
+
+// Box-window Steps 3-4 fused
+inline void harrisBoxResponse(const cv::Mat& Ixx, const cv::Mat& Iyy, const cv::Mat& Ixy,
+                              cv::Mat& response, int blockSize, double k) {
+    cv::Mat sums;
+    harrisBoxIntegral(Ixx, Iyy, Ixy, sums);
+    harrisBoxResponse(sums, response, blockSize, k);
+}
+
+// Full manual Harris pipeline on an 8-bit grayscale image (serial).
+// Parameters follow cv::cornerHarris: the window is (2*blockSize+1)^2.
+inline void computeHarris(const cv::Mat& gray, cv::Mat& response,
+                          int blockSize, int apertureSize, double k,
+                          HarrisWindow window = HARRIS_WINDOW_GAUSSIAN) {
+    // Step 1: Image gradients Ix, Iy
+    cv::Mat Ix, Iy;
+    cv::Sobel(gray, Ix, CV_32F, 1, 0, apertureSize);
+    cv::Sobel(gray, Iy, CV_32F, 0, 1, apertureSize);
+
+    // Step 2: Gradient products
+    cv::Mat Ixx, Iyy, Ixy;
+    cv::multiply(Ix, Ix, Ixx);
+    cv::multiply(Iy, Iy, Iyy);
+    cv::multiply(Ix, Iy, Ixy);
+
+    if (window == HARRIS_WINDOW_BOX) {
+        // Steps 3-4 fused over the integral images
+        harrisBoxResponse(Ixx, Iyy, Ixy, response, blockSize, k);
+        return;
+    }
+
+    // Step 3: Gaussian-weighted structure tensor
+    int kernelSize = blockSize * 2 + 1;
+    cv::Mat Sxx, Syy, Sxy;
+    cv::GaussianBlur(Ixx, Sxx, cv::Size(kernelSize, kernelSize), 0);
+    cv::GaussianBlur(Iyy, Syy, cv::Size(kernelSize, kernelSize), 0);
+    cv::GaussianBlur(Ixy, Sxy, cv::Size(kernelSize, kernelSize), 0);
+
+    // Step 4: R = det(M) - k * trace(M)^2
+    computeHarrisResponse(Sxx, Syy, Sxy, response, k);
+}
+
+// Rows of context a strip needs on each side so its interior matches the
+// whole-image result: Sobel aperture radius plus window radius.
+inline int harrisHaloRows(int blockSize, int apertureSize) {
+    return apertureSize / 2 + blockSize;
+}
+
+// Tiled, multi-threaded variant of computeHarris().
+// The image is split into row strips; each strip is processed together with
+// harrisHaloRows() rows of context above and below and only its own rows are
+// kept, so the output is bit-identical to the serial path (box window: equal
+// up to double rounding, since each strip has its own integral image).
+// Strips run on OpenCV's thread pool (cv::parallel_for_, sized by
+// cv::setNumThreads). stripRows <= 0 picks a strip height from the current
+// thread count.
+inline void computeHarrisTiled(const cv::Mat& gray, cv::Mat& response,
+                               int blockSize, int apertureSize, double k,
+                               int stripRows = 0,
+                               HarrisWindow window = HARRIS_WINDOW_GAUSSIAN) {
+    const int rows = gray.rows;
+    const int halo = harrisHaloRows(blockSize, apertureSize);
+
+    if (stripRows <= 0) {
+        int strips = std::max(1, cv::getNumThreads() * 4);
+        stripRows = std::max(4 * halo, (rows + strips - 1) / strips);
+    }
+    if (stripRows >= rows) {
+        computeHarris(gray, response, blockSize, apertureSize, k, window);
+        return;
+    }
+
+    response.create(gray.size(), CV_32F);
+    cv::Mat dst = response;
+    const int numStrips = (rows + stripRows - 1) / stripRows;
+
+    cv::parallel_for_(cv::Range(0, numStrips), [&](const cv::Range& range) {
+        for (int s = range.start; s < range.end; s++) {
+            int r0 = s * stripRows, r1 = std::min(rows, r0 + stripRows);
+            int e0 = std::max(0, r0 - halo), e1 = std::min(rows, r1 + halo);
+
+            cv::Mat stripResponse;
+            computeHarris(gray.rowRange(e0, e1), stripResponse, blockSize, apertureSize, k, window);
+            stripResponse.rowRange(r0 - e0, r1 - e0).copyTo(dst.rowRange(r0, r1));
+        }
+    });
+}
+
+#endif // HARRIS_CORE_HPP
@@ -0,0 +1,169 @@
+#ifndef HARRIS_FIXED_HPP
+#define HARRIS_FIXED_HPP
+
+#include <opencv2/core.hpp>
+#include <opencv2/core/hal/intrin.hpp>
+#include <opencv2/imgproc.hpp>
+#include <vector>
+
+#include "harris_core.hpp"
+
+// Fixed-point Harris for 8-bit input (aperture 3, block 1 or 2).
+//
+// Gradients stay CV_16S (|I'| <= 1020 for a 3x3 Sobel), products and the
+// windowed sums are int32, and only the final R = det - k * trace^2 is done
+// in float. The window is the binomial kernel GaussianBlur uses for 3x3 and
+// 5x5 with sigma 0 ([1 2 1]/4, [1 4 6 4 1]/16), applied with integer taps, so
+// the sums are exact: the largest 5x5 sum is 1020^2 * 256 < 2^31. The
+// power-of-two normalization is folded into the int -> float conversion,
+// so the response equals the float path up to its rounding and corners rank
+// the same.
+//
+// Products are formed on the fly from the int16 gradient rows inside the
+// window pass, so no int32 product planes are stored. The vertical taps run as
+// int16 multiply-adds (v_dotprod), twice the lanes of an int32 multiply; the
+// horizontal taps stay int32 since the column sums no longer fit 16 bits.
+
+template<int Block> struct BinomialTaps;
+template<> struct BinomialTaps<1> {
+    static int tap(int i) { static const int t[] = { 1, 2, 1 }; return t[i]; }
+    static const int SUM = 4;
+};
+template<> struct BinomialTaps<2> {
+    static int tap(int i) { static const int t[] = { 1, 4, 6, 4, 1 }; return t[i]; }
+    static const int SUM = 16;
+};
+
+// Vertical window pass for one output row over the N gradient rows of the
+// window: axx[x] = sum_t taps[t] * gx_t[x]^2, likewise ayy and axy. Two window
+// rows are interleaved so each v_dotprod lane adds
+// gx_t * (taps[t] * gx_t) + gx_t+1 * (taps[t+1] * gx_t+1); the weighted factor
+// is below 6 * 1020 and fits int16, the pair sum fits int32.
+template<int N>
+inline void harrisFixedWindowRows(const short* const* gx, const short* const* gy, const int* taps,
+                                  int width, int* axx, int* ayy, int* axy) {
+    int x = 0;
+#if CV_SIMD
+    const int lanes = cv::v_int16::nlanes, half = cv::v_int32::nlanes;
+    for (; x <= width - lanes; x += lanes) {
+        cv::v_int32 xx0 = cv::vx_setzero_s32(), xx1 = cv::vx_setzero_s32();
+        cv::v_int32 yy0 = cv::vx_setzero_s32(), yy1 = cv::vx_setzero_s32();
+        cv::v_int32 xy0 = cv::vx_setzero_s32(), xy1 = cv::vx_setzero_s32();
+        for (int t = 0; t < N; t += 2) {
+            cv::v_int16 a0 = cv::vx_load(gx[t] + x), b0 = cv::vx_load(gy[t] + x);
+            cv::v_int16 w0 = cv::vx_setall_s16((short)taps[t]);
+            cv::v_int16 a1 = cv::vx_setzero_s16(), b1 = cv::vx_setzero_s16(), w1 = w0;
+            if (t + 1 < N) {
+                a1 = cv::vx_load(gx[t + 1] + x);
+                b1 = cv::vx_load(gy[t + 1] + x);
+                w1 = cv::vx_setall_s16((short)taps[t + 1]);
+            }
+            cv::v_int16 ga0, ga1, gb0, gb1, wa0, wa1, wb0, wb1;
+            cv::v_zip(a0, a1, ga0, ga1);
+            cv::v_zip(b0, b1, gb0, gb1);
+            cv::v_zip(a0 * w0, a1 * w1, wa0, wa1);
+            cv::v_zip(b0 * w0, b1 * w1, wb0, wb1);
+            xx0 += cv::v_dotprod(ga0, wa0); xx1 += cv::v_dotprod(ga1, wa1);
+            yy0 += cv::v_dotprod(gb0, wb0); yy1 += cv::v_dotprod(gb1, wb1);
+            xy0 += cv::v_dotprod(ga0, wb0); xy1 += cv::v_dotprod(ga1, wb1);
+        }
+        cv::v_store(axx + x, xx0); cv::v_store(axx + x + half, xx1);
+        cv::v_store(ayy + x, yy0); cv::v_store(ayy + x + half, yy1);
+        cv::v_store(axy + x, xy0); cv::v_store(axy + x + half, xy1);
+    }
+#endif
+    for (; x < width; x++) {
+        int sxx = 0, syy = 0, sxy = 0;
+        for (int t = 0; t < N; t++) {
+            int a = gx[t][x], b = gy[t][x];
+            sxx += taps[t] * a * a;
+            syy += taps[t] * b * b;
+            sxy += taps[t] * a * b;
+        }
+        axx[x] = sxx; ayy[x] = syy; axy[x] = sxy;
+    }
+}
+
+template<int Block>
+inline void computeHarrisFixedBlock(const cv::Mat& gray, cv::Mat& response, float k) {
+    const int N = 2 * Block + 1;
+    const int rows = gray.rows, cols = gray.cols, pw = cols + 2 * Block;
+
+    int taps[N];
+    for (int t = 0; t < N; t++) taps[t] = BinomialTaps<Block>::tap(t);
+    const float scale = 1.f / (BinomialTaps<Block>::SUM * BinomialTaps<Block>::SUM);
+
+    // Step 1: int16 gradients, reflect-101 padded by the window radius
+    cv::Mat ix, iy, ixp, iyp;
+    cv::Sobel(gray, ix, CV_16S, 1, 0, 3);
+    cv::Sobel(gray, iy, CV_16S, 0, 1, 3);
+    cv::copyMakeBorder(ix, ixp, Block, Block, Block, Block, cv::BORDER_REFLECT_101);
+    cv::copyMakeBorder(iy, iyp, Block, Block, Block, Block, cv::BORDER_REFLECT_101);
+
+    response.create(gray.size(), CV_32F);
+    cv::Mat dst = response;
+
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& range) {
+        std::vector<int> axx(pw), ayy(pw), axy(pw);
+        std::vector<float> sxx(cols), syy(cols), sxy(cols);
+
+        for (int y = range.start; y < range.end; y++) {
+            // Steps 2-3a: products of each window row, vertical taps
+            const short* gx[N];
+            const short* gy[N];
+            for (int t = 0; t < N; t++) {
+                gx[t] = ixp.ptr<short>(y + t);
+                gy[t] = iyp.ptr<short>(y + t);
+            }
+            harrisFixedWindowRows<N>(gx, gy, taps, pw, &axx[0], &ayy[0], &axy[0]);
+
+            // Step 3b: horizontal taps, then scale to the normalized window
+            int x = 0;
+#if CV_SIMD
+            const int lanes = cv::v_int32::nlanes;
+            cv::v_float32 vscale = cv::vx_setall_f32(scale);
+            for (; x <= cols - lanes; x += lanes) {
+                cv::v_int32 s0 = cv::vx_setzero_s32(), s1 = cv::vx_setzero_s32(), s2 = cv::vx_setzero_s32();
+                for (int t = 0; t < N; t++) {
+                    cv::v_int32 vt = cv::vx_setall_s32(taps[t]);
+                    s0 += vt * cv::vx_load(&axx[x + t]);
+                    s1 += vt * cv::vx_load(&ayy[x + t]);
+                    s2 += vt * cv::vx_load(&axy[x + t]);
+                }
+                cv::v_store(&sxx[x], cv::v_cvt_f32(s0) * vscale);
+                cv::v_store(&syy[x], cv::v_cvt_f32(s1) * vscale);
+                cv::v_store(&sxy[x], cv::v_cvt_f32(s2) * vscale);
+            }
+#endif
+            for (; x < cols; x++) {
+                int s0 = 0, s1 = 0, s2 = 0;
+                for (int t = 0; t < N; t++) {
+                    s0 += taps[t] * axx[x + t];
+                    s1 += taps[t] * ayy[x + t];
+                    s2 += taps[t] * axy[x + t];
+                }
+                sxx[x] = s0 * scale;
+                syy[x] = s1 * scale;
+                sxy[x] = s2 * scale;
+            }
+
+            // Step 4: R = det(M) - k * trace(M)^2
+            harrisResponseRow(&sxx[0], &syy[0], &sxy[0], dst.ptr<float>(y), cols, k);
+        }
+    });
+}
+
+// Fixed-point Harris when the parameters allow it (8-bit input, aperture 3,
+// blockSize 1 or 2). Returns false otherwise so callers can fall back to
+// the float pipeline.
+inline bool computeHarrisFixed(const cv::Mat& gray, cv::Mat& response,
+                               int blockSize, int apertureSize, double k) {
+    if (gray.type() != CV_8U || apertureSize != 3) return false;
+    switch (blockSize) {
+        case 1: computeHarrisFixedBlock<1>(gray, response, (float)k); return true;
+        case 2: computeHarrisFixedBlock<2>(gray, response, (float)k); return true;
+        default: return false;
+    }
+}
+
+#endif // HARRIS_FIXED_HPP
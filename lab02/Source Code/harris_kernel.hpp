@@ -0,0 +1,209 @@
+#ifndef HARRIS_KERNEL_HPP
+#define HARRIS_KERNEL_HPP
+
+#include <opencv2/core.hpp>
+#include <opencv2/core/hal/intrin.hpp>
+#include <opencv2/imgproc.hpp>
+#include <vector>
+
+#include "harris_core.hpp"
+
+// Compile-time specialized Harris pipeline.
+//
+// HarrisKernel<Aperture, Block> computes the same response as computeHarris()
+// (Sobel aperture 3/5/7, Gaussian window 2*Block+1, BORDER_REFLECT_101) but
+// with every filter length a template constant: the tap loops are fully
+// unrolled, the taps stay in registers and the pixel loops use universal
+// intrinsics. Rows are independent, so both passes run on cv::parallel_for_.
+// Results match computeHarris() up to float rounding.
+//
+// computeHarrisSpecialized() picks the instantiation from runtime values;
+// computeHarrisAuto() falls back to computeHarris() when there is none.
+
+// Unnormalized Sobel taps (cv::getDerivKernels with normalize = false)
+template<int Aperture> struct SobelTaps;
+
+template<> struct SobelTaps<3> {
+    static float smooth(int i) { static const float t[] = { 1, 2, 1 }; return t[i]; }
+    static float deriv(int i)  { static const float t[] = { -1, 0, 1 }; return t[i]; }
+};
+
+template<> struct SobelTaps<5> {
+    static float smooth(int i) { static const float t[] = { 1, 4, 6, 4, 1 }; return t[i]; }
+    static float deriv(int i)  { static const float t[] = { -1, -2, 0, 2, 1 }; return t[i]; }
+};
+
+template<> struct SobelTaps<7> {
+    static float smooth(int i) { static const float t[] = { 1, 6, 15, 20, 15, 6, 1 }; return t[i]; }
+    static float deriv(int i)  { static const float t[] = { -1, -4, -5, 0, 5, 4, 1 }; return t[i]; }
+};
+
+// dst[x] = sum_t taps[t] * rows[t][x]
+template<int N>
+inline void convolveColumns(const float* const* rows, const float* taps, float* dst, int width) {
+    int x = 0;
+#if CV_SIMD
+    const int lanes = cv::v_float32::nlanes;
+    cv::v_float32 vt[N];
+    for (int t = 0; t < N; t++) vt[t] = cv::vx_setall_f32(taps[t]);
+    for (; x <= width - lanes; x += lanes) {
+        cv::v_float32 acc = cv::vx_load(rows[0] + x) * vt[0];
+        for (int t = 1; t < N; t++) acc += cv::vx_load(rows[t] + x) * vt[t];
+        cv::v_store(dst + x, acc);
+    }
+#endif
+    for (; x < width; x++) {
+        float acc = 0.f;
+        for (int t = 0; t < N; t++) acc += taps[t] * rows[t][x];
+        dst[x] = acc;
+    }
+}
+
+// dst[x] = sum_t taps[t] * src[x + t]   (src holds width + N - 1 values)
+template<int N>
+inline void convolveRow(const float* src, const float* taps, float* dst, int width) {
+    int x = 0;
+#if CV_SIMD
+    const int lanes = cv::v_float32::nlanes;
+    cv::v_float32 vt[N];
+    for (int t = 0; t < N; t++) vt[t] = cv::vx_setall_f32(taps[t]);
+    for (; x <= width - lanes; x += lanes) {
+        cv::v_float32 acc = cv::vx_load(src + x) * vt[0];
+        for (int t = 1; t < N; t++) acc += cv::vx_load(src + x + t) * vt[t];
+        cv::v_store(dst + x, acc);
+    }
+#endif
+    for (; x < width; x++) {
+        float acc = 0.f;
+        for (int t = 0; t < N; t++) acc += taps[t] * src[x + t];
+        dst[x] = acc;
+    }
+}
+
+template<int Aperture, int Block>
+struct HarrisKernel {
+    static const int SOBEL_TAPS = Aperture;
+    static const int SOBEL_RADIUS = Aperture / 2;
+    static const int WINDOW_TAPS = 2 * Block + 1;
+
+    static void compute(const cv::Mat& gray, cv::Mat& response, float k) {
+        CV_Assert(gray.type() == CV_8U);
+        const int rows = gray.rows, cols = gray.cols;
+        const int R = SOBEL_RADIUS, B = Block;
+
+        float smooth[SOBEL_TAPS], deriv[SOBEL_TAPS];
+        for (int t = 0; t < SOBEL_TAPS; t++) {
+            smooth[t] = SobelTaps<Aperture>::smooth(t);
+            deriv[t] = SobelTaps<Aperture>::deriv(t);
+        }
+        // sigma 0: same kernel GaussianBlur(Size(2b+1, 2b+1), 0) derives
+        cv::Mat g = cv::getGaussianKernel(WINDOW_TAPS, 0, CV_32F);
+        float gauss[WINDOW_TAPS];
+        for (int t = 0; t < WINDOW_TAPS; t++) gauss[t] = g.at<float>(t);
+
+        // Input with reflect-101 borders for the Sobel taps
+        cv::Mat padded, src;
+        cv::copyMakeBorder(gray, padded, R, R, R, R, cv::BORDER_REFLECT_101);
+        padded.convertTo(src, CV_32F);
+
+        // Gradient products, padded by Block columns for the window pass
+        const int pw = cols + 2 * B;
+        cv::Mat pxx(rows, pw, CV_32F), pyy(rows, pw, CV_32F), pxy(rows, pw, CV_32F);
+
+        // Steps 1-2: Sobel (vertical then horizontal taps) and products
+        cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& range) {
+            const int sw = cols + 2 * R;
+            std::vector<float> vs(sw), vd(sw), ix(cols), iy(cols);
+            const float* in[SOBEL_TAPS];
+
+            for (int y = range.start; y < range.end; y++) {
+                for (int t = 0; t < SOBEL_TAPS; t++) in[t] = src.ptr<float>(y + t);
+                convolveColumns<SOBEL_TAPS>(in, smooth, &vs[0], sw);
+                convolveColumns<SOBEL_TAPS>(in, deriv, &vd[0], sw);
+                convolveRow<SOBEL_TAPS>(&vs[0], deriv, &ix[0], cols);
+                convolveRow<SOBEL_TAPS>(&vd[0], smooth, &iy[0], cols);
+
+                float* a = pxx.ptr<float>(y) + B;
+                float* b = pyy.ptr<float>(y) + B;
+                float* c = pxy.ptr<float>(y) + B;
+                for (int x = 0; x < cols; x++) {
+                    a[x] = ix[x] * ix[x];
+                    b[x] = iy[x] * iy[x];
+                    c[x] = ix[x] * iy[x];
+                }
+                for (int x = 1; x <= B; x++) {
+                    int l = cv::borderInterpolate(-x, cols, cv::BORDER_REFLECT_101);
+                    int r = cv::borderInterpolate(cols - 1 + x, cols, cv::BORDER_REFLECT_101);
+                    a[-x] = a[l]; b[-x] = b[l]; c[-x] = c[l];
+                    a[cols - 1 + x] = a[r]; b[cols - 1 + x] = b[r]; c[cols - 1 + x] = c[r];
+                }
+            }
+        });
+
+        // Steps 3-4: Gaussian window (vertical then horizontal) and response
+        response.create(gray.size(), CV_32F);
+        cv::Mat dst = response;
+        cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& range) {
+            std::vector<float> txx(pw), tyy(pw), txy(pw), sxx(cols), syy(cols), sxy(cols);
+            const float *wxx[WINDOW_TAPS], *wyy[WINDOW_TAPS], *wxy[WINDOW_TAPS];
+
+            for (int y = range.start; y < range.end; y++) {
+                for (int t = 0; t < WINDOW_TAPS; t++) {
+                    int sy = cv::borderInterpolate(y + t - B, rows, cv::BORDER_REFLECT_101);
+                    wxx[t] = pxx.ptr<float>(sy);
+                    wyy[t] = pyy.ptr<float>(sy);
+                    wxy[t] = pxy.ptr<float>(sy);
+                }
+                convolveColumns<WINDOW_TAPS>(wxx, gauss, &txx[0], pw);
+                convolveColumns<WINDOW_TAPS>(wyy, gauss, &tyy[0], pw);
+                convolveColumns<WINDOW_TAPS>(wxy, gauss, &txy[0], pw);
+                convolveRow<WINDOW_TAPS>(&txx[0], gauss, &sxx[0], cols);
+                convolveRow<WINDOW_TAPS>(&tyy[0], gauss, &syy[0], cols);
+                convolveRow<WINDOW_TAPS>(&txy[0], gauss, &sxy[0], cols);
+                harrisResponseRow(&sxx[0], &syy[0], &sxy[0], dst.ptr<float>(y), cols, k);
+            }
+        });
+    }
+};
+
+// Runtime dispatch over the block sizes the trackbars allow (1-10)
+template<int Aperture>
+inline bool dispatchHarrisBlock(const cv::Mat& gray, cv::Mat& response, int blockSize, float k) {
+    switch (blockSize) {
+        case 1:  HarrisKernel<Aperture, 1>::compute(gray, response, k); return true;
+        case 2:  HarrisKernel<Aperture, 2>::compute(gray, response, k); return true;
+        case 3:  HarrisKernel<Aperture, 3>::compute(gray, response, k); return true;
+        case 4:  HarrisKernel<Aperture, 4>::compute(gray, response, k); return true;
+        case 5:  HarrisKernel<Aperture, 5>::compute(gray, response, k); return true;
+        case 6:  HarrisKernel<Aperture, 6>::compute(gray, response, k); return true;
+        case 7:  HarrisKernel<Aperture, 7>::compute(gray, response, k); return true;
+        case 8:  HarrisKernel<Aperture, 8>::compute(gray, response, k); return true;
+        case 9:  HarrisKernel<Aperture, 9>::compute(gray, response, k); return true;
+        case 10: HarrisKernel<Aperture, 10>::compute(gray, response, k); return true;
+        default: return false;
+    }
+}
+
+// HarrisKernel<apertureSize, blockSize> for an 8-bit image. Returns false
+// (response untouched) when no instantiation exists, so callers can fall
+// back to computeHarris().
+inline bool computeHarrisSpecialized(const cv::Mat& gray, cv::Mat& response,
+                                     int blockSize, int apertureSize, double k) {
+    if (gray.type() != CV_8U) return false;
+    switch (apertureSize) {
+        case 3: return dispatchHarrisBlock<3>(gray, response, blockSize, (float)k);
+        case 5: return dispatchHarrisBlock<5>(gray, response, blockSize, (float)k);
+        case 7: return dispatchHarrisBlock<7>(gray, response, blockSize, (float)k);
+        default: return false;
+    }
+}
+
+// Harris with the fastest available implementation: the specialized kernel,
+// or the generic computeHarris() for parameters it does not cover
+inline void computeHarrisAuto(const cv::Mat& gray, cv::Mat& response,
+                              int blockSize, int apertureSize, double k) {
+    if (!computeHarrisSpecialized(gray, response, blockSize, apertureSize, k))
+        computeHarris(gray, response, blockSize, apertureSize, k);
+}
+
+#endif // HARRIS_KERNEL_HPP
@@ -0,0 +1,125 @@
+#ifndef HARRIS_SPARSE_HPP
+#define HARRIS_SPARSE_HPP
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <vector>
+
+#include "harris_core.hpp"
+
+// Sparse coarse-to-fine Harris.
+//
+// Stage 1 evaluates the response densely on a pyrDown (2x decimated) copy of
+// the image, a quarter of the pixels. Stage 2 runs the full-resolution
+// pipeline only on the tiles around coarse local maxima that pass a
+// deliberately loose threshold. Each tile is computed with harrisHaloRows()
+// pixels of context on every side, so evaluated pixels match computeHarris()
+// on the whole image. Everything else is left at -FLT_MAX.
+
+struct HarrisSparseResult {
+    cv::Mat response;       // full size CV_32F, -FLT_MAX outside evaluated tiles
+    float minResponse;      // estimate of the dense response minimum
+    float maxResponse;      // maximum over evaluated tiles
+    int candidates;         // coarse local maxima that passed
+    int tilesEvaluated;
+    int tilesTotal;
+};
+
+// coarseThreshold is on the 0..255 min/max-normalized scale of the coarse
+// response; keep it well below the final threshold so corners whose coarse
+// response is blurred down are still refined. `half` may pass in
+// pyrDown(gray) when the caller already has it (ImagePyramid::level(1)).
+inline void computeHarrisSparse(const cv::Mat& gray, HarrisSparseResult& result,
+                                int blockSize, int apertureSize, double k,
+                                double coarseThreshold = 120, int tileSize = 64,
+                                const cv::Mat& half = cv::Mat()) {
+    const int rows = gray.rows, cols = gray.cols;
+    const int halo = harrisHaloRows(blockSize, apertureSize);
+
+    // Stage 1: coarse response; block size halved to keep the window footprint
+    cv::Mat small = half, coarse;
+    if (small.empty()) cv::pyrDown(gray, small);
+    computeHarrisTiled(small, coarse, std::max(1, blockSize / 2), apertureSize, k);
+
+    double coarseMin, coarseMax;
+    cv::minMaxLoc(coarse, &coarseMin, &coarseMax);
+    float coarseCut = (float)(coarseMin + coarseThreshold / 255.0 * (coarseMax - coarseMin));
+
+    // 3x3 coarse local maxima above the cut mark the tiles around them
+    const int tilesX = (cols + tileSize - 1) / tileSize, tilesY = (rows + tileSize - 1) / tileSize;
+    const int reach = 3;   // full-resolution slack around the upsampled position
+    std::vector<uchar> marked(tilesX * tilesY, 0);
+    result.candidates = 0;
+
+    for (int y = 0; y < coarse.rows; y++) {
+        const float* c = coarse.ptr<float>(y);
+        const float* up = coarse.ptr<float>(std::max(0, y - 1));
+        const float* down = coarse.ptr<float>(std::min(coarse.rows - 1, y + 1));
+        for (int x = 0; x < coarse.cols; x++) {
+            float v = c[x];
+            if (v <= coarseCut) continue;
+            int x0 = std::max(0, x - 1), x1 = std::min(coarse.cols - 1, x + 1);
+            bool isMax = true;
+            for (int xx = x0; xx <= x1 && isMax; xx++) {
+                if (up[xx] > v || down[xx] > v || c[xx] > v) isMax = false;
+            }
+            if (!isMax) continue;
+
+            result.candidates++;
+            int fx0 = std::max(0, 2 * x - reach) / tileSize, fx1 = std::min(cols - 1, 2 * x + 1 + reach) / tileSize;
+            int fy0 = std::max(0, 2 * y - reach) / tileSize, fy1 = std::min(rows - 1, 2 * y + 1 + reach) / tileSize;
+            for (int ty = fy0; ty <= fy1; ty++)
+                for (int tx = fx0; tx <= fx1; tx++) marked[ty * tilesX + tx] = 1;
+        }
+    }
+
+    std::vector<int> tiles;
+    for (int i = 0; i < (int)marked.size(); i++) if (marked[i]) tiles.push_back(i);
+    result.tilesEvaluated = (int)tiles.size();
+    result.tilesTotal = tilesX * tilesY;
+
+    auto tileRect = [&](int index) {
+        int x = (index % tilesX) * tileSize, y = (index / tilesX) * tileSize;
+        return cv::Rect(x, y, std::min(tileSize, cols - x), std::min(tileSize, rows - y));
+    };
+
+    // Stage 2: full-resolution Harris on the marked tiles only
+    result.response.create(gray.size(), CV_32F);
+    result.response.setTo(cv::Scalar::all(-FLT_MAX));
+    cv::Mat dst = result.response;
+
+    cv::parallel_for_(cv::Range(0, (int)tiles.size()), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; i++) {
+            cv::Rect tile = tileRect(tiles[i]);
+            cv::Rect ext(tile.x - halo, tile.y - halo, tile.width + 2 * halo, tile.height + 2 * halo);
+            ext &= cv::Rect(0, 0, cols, rows);
+
+            cv::Mat tileResponse;
+            computeHarris(gray(ext), tileResponse, blockSize, apertureSize, k);
+            tileResponse(cv::Rect(tile.x - ext.x, tile.y - ext.y, tile.width, tile.height))
+                .copyTo(dst(tile));
+        }
+    });
+
+    // Dense min/max estimates for the usual normalized threshold. The maximum
+    // sits on a corner, which was refined. The minimum (strongest edge) may
+    // lie in a skipped tile, so the coarse minimum is also considered, scaled
+    // by the fine/coarse ratio of the maxima.
+    float tileMin = FLT_MAX, tileMax = -FLT_MAX;
+    for (size_t i = 0; i < tiles.size(); i++) {
+        double lo, hi;
+        cv::minMaxLoc(dst(tileRect(tiles[i])), &lo, &hi);
+        tileMin = std::min(tileMin, (float)lo);
+        tileMax = std::max(tileMax, (float)hi);
+    }
+    if (tiles.empty()) {
+        tileMin = tileMax = 0.f;
+    }
+    float scaledMin = coarseMax > 0 ? (float)(coarseMin * (tileMax / coarseMax)) : tileMin;
+    result.minResponse = std::min(tileMin, scaledMin);
+    result.maxResponse = tileMax;
+}
+
+#endif // HARRIS_SPARSE_HPP
@@ -0,0 +1,250 @@
+#ifndef HARRIS_STREAM_HPP
+#define HARRIS_STREAM_HPP
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "harris_core.hpp"
+
+// Streaming (line-buffer) Harris detector with bounded memory.
+//
+// Rows of the 8-bit input are pushed one at a time. Every stage of the
+// pipeline (Sobel, gradient products + Gaussian window, response, 3x3 local
+// maximum test) keeps only the rolling window of rows its vertical kernel
+// needs, so working memory is O(width * (aperture + 2*blockSize + 3)) instead
+// of ten full-size float planes. Borders are BORDER_REFLECT_101 like the
+// whole-image path; results match it up to float rounding.
+//
+// Corner candidates (3x3 local maxima with a positive response) are emitted
+// as soon as the rows around them are known. The global response min/max are
+// tracked on the fly, so the usual "normalize to 0..255 then threshold" rule
+// can be applied to the candidates at the end without a second pass.
+
+struct HarrisCandidate {
+    cv::Point pt;
+    float response;
+};
+
+class HarrisStream {
+public:
+    HarrisStream(int width, int height, int blockSize, int apertureSize, double k)
+        : width(width), height(height), k((float)k),
+          inputRows(0), gradRows(0), tensorRows(0), nmsRows(0),
+          minR(std::numeric_limits<float>::max()),
+          maxR(-std::numeric_limits<float>::max()) {
+        // Sobel = derivative kernel along one axis, smoothing along the other
+        cv::Mat dx, sy, sx, dy;
+        cv::getDerivKernels(dx, sy, 1, 0, apertureSize, false, CV_32F);
+        cv::getDerivKernels(sx, dy, 0, 1, apertureSize, false, CV_32F);
+        derivX = toVector(dx); smoothY = toVector(sy);
+        smoothX = toVector(sx); derivY = toVector(dy);
+
+        // Same Gaussian window as GaussianBlur(Size(2b+1, 2b+1), 0); sigma 0
+        // also selects OpenCV's fixed small-kernel tables for sizes <= 7
+        gauss = toVector(cv::getGaussianKernel(blockSize * 2 + 1, 0, CV_32F));
+
+        sobelRadius = apertureSize / 2;
+        gaussRadius = blockSize;
+        sobelSpan = 2 * sobelRadius + 1;
+        gaussSpan = 2 * gaussRadius + 1;
+
+        // Rolling windows
+        hx.assign((size_t)sobelSpan * width, 0.f);
+        hy.assign((size_t)sobelSpan * width, 0.f);
+        pxx.assign((size_t)gaussSpan * width, 0.f);
+        pyy.assign((size_t)gaussSpan * width, 0.f);
+        pxy.assign((size_t)gaussSpan * width, 0.f);
+        resp.assign((size_t)3 * width, 0.f);
+
+        // Scratch rows
+        int maxRadius = std::max(sobelRadius, gaussRadius);
+        padded.assign(width + 2 * maxRadius, 0.f);
+        ix.assign(width, 0.f); iy.assign(width, 0.f);
+        prod.assign(width, 0.f);
+        sxx.assign(width, 0.f); syy.assign(width, 0.f); sxy.assign(width, 0.f);
+    }
+
+    // Feed the next input row (CV_8U, `width` pixels)
+    void pushRow(const uchar* row) {
+        CV_Assert(inputRows < height);
+        int y = inputRows++;
+
+        // Stage 1: horizontal Sobel passes into the gradient window
+        padRow(row, sobelRadius);
+        correlate(derivX, ringRow(hx, sobelSpan, y));
+        correlate(smoothX, ringRow(hy, sobelSpan, y));
+
+        // Stage 2..4 run as far as the available rows allow
+        bool last = (inputRows == height);
+        while (gradRows < height && (gradRows + sobelRadius < inputRows || last)) {
+            emitGradientRow(gradRows++);
+        }
+    }
+
+    void pushImage(const cv::Mat& gray) {
+        CV_Assert(gray.type() == CV_8U && gray.cols == width && gray.rows == height);
+        for (int y = 0; y < gray.rows; y++) pushRow(gray.ptr<uchar>(y));
+    }
+
+    bool finished() const { return nmsRows == height; }
+
+    // All 3x3 local maxima with a positive response seen so far
+    const std::vector<HarrisCandidate>& candidates() const { return found; }
+
+    float minResponse() const { return minR; }
+    float maxResponse() const { return maxR; }
+
+    // Candidates whose min/max-normalized response (0..255) exceeds normThreshold,
+    // i.e. the same rule as normalize(NORM_MINMAX) + threshold(THRESH_BINARY).
+    std::vector<HarrisCandidate> corners(double normThreshold) const {
+        std::vector<HarrisCandidate> result;
+        double range = (double)maxR - minR;
+        if (range <= 0) return result;
+        double cutoff = minR + normThreshold / 255.0 * range;
+        for (size_t i = 0; i < found.size(); i++) {
+            if (found[i].response > cutoff) result.push_back(found[i]);
+        }
+        return result;
+    }
+
+    // Bytes held by the rolling windows and scratch rows
+    size_t bufferBytes() const {
+        size_t floats = hx.size() + hy.size() + pxx.size() + pyy.size() + pxy.size() + resp.size()
+                      + padded.size() + ix.size() + iy.size() + prod.size()
+                      + sxx.size() + syy.size() + sxy.size();
+        return floats * sizeof(float);
+    }
+
+private:
+    int width, height;
+    float k;
+    int sobelRadius, gaussRadius, sobelSpan, gaussSpan;
+    std::vector<float> derivX, smoothY, smoothX, derivY, gauss;
+
+    int inputRows, gradRows, tensorRows, nmsRows;
+    std::vector<float> hx, hy;          // horizontally filtered input rows
+    std::vector<float> pxx, pyy, pxy;   // horizontally smoothed gradient products
+    std::vector<float> resp;            // last three response rows
+    std::vector<float> padded, ix, iy, prod, sxx, syy, sxy;
+
+    float minR, maxR;
+    std::vector<HarrisCandidate> found;
+
+    static std::vector<float> toVector(const cv::Mat& kernel) {
+        cv::Mat k32;
+        kernel.convertTo(k32, CV_32F);
+        return std::vector<float>(k32.ptr<float>(), k32.ptr<float>() + k32.total());
+    }
+
+    float* ringRow(std::vector<float>& ring, int span, int y) {
+        return &ring[(size_t)(y % span) * width];
+    }
+
+    // Ring row for image row y with reflect-101 borders applied
+    float* ringRowReflect(std::vector<float>& ring, int span, int y) {
+        return ringRow(ring, span, cv::borderInterpolate(y, height, cv::BORDER_REFLECT_101));
+    }
+
+    // Copy a row into `padded` with `radius` reflect-101 pixels on each side
+    template<typename T>
+    void padRow(const T* src, int radius) {
+        float* p = &padded[radius];
+        for (int x = 0; x < width; x++) p[x] = (float)src[x];
+        for (int x = 1; x <= radius; x++) {
+            p[-x] = (float)src[cv::borderInterpolate(-x, width, cv::BORDER_REFLECT_101)];
+            p[width - 1 + x] = (float)src[cv::borderInterpolate(width - 1 + x, width, cv::BORDER_REFLECT_101)];
+        }
+    }
+
+    // dst[x] = sum_t kernel[t] * padded[x + t], kernel centred on the padding radius
+    void correlate(const std::vector<float>& kernel, float* dst) {
+        const int n = (int)kernel.size();
+        for (int x = 0; x < width; x++) dst[x] = 0.f;
+        for (int t = 0; t < n; t++) {
+            const float kt = kernel[t];
+            const float* src = &padded[t];
+            for (int x = 0; x < width; x++) dst[x] += kt * src[x];
+        }
+    }
+
+    // dst[x] = sum_t kernel[t] * ring[y + t - radius][x]
+    void verticalPass(std::vector<float>& ring, int span, const std::vector<float>& kernel,
+                      int radius, int y, float* dst) {
+        for (int x = 0; x < width; x++) dst[x] = 0.f;
+        for (int t = 0; t < (int)kernel.size(); t++) {
+            const float kt = kernel[t];
+            const float* src = ringRowReflect(ring, span, y + t - radius);
+            for (int x = 0; x < width; x++) dst[x] += kt * src[x];
+        }
+    }
+
+    // Stage 2: vertical Sobel, gradient products, horizontal Gaussian
+    void emitGradientRow(int y) {
+        verticalPass(hx, sobelSpan, smoothY, sobelRadius, y, &ix[0]);
+        verticalPass(hy, sobelSpan, derivY, sobelRadius, y, &iy[0]);
+
+        for (int x = 0; x < width; x++) prod[x] = ix[x] * ix[x];
+        padRow(&prod[0], gaussRadius);
+        correlate(gauss, ringRow(pxx, gaussSpan, y));
+
+        for (int x = 0; x < width; x++) prod[x] = iy[x] * iy[x];
+        padRow(&prod[0], gaussRadius);
+        correlate(gauss, ringRow(pyy, gaussSpan, y));
+
+        for (int x = 0; x < width; x++) prod[x] = ix[x] * iy[x];
+        padRow(&prod[0], gaussRadius);
+        correlate(gauss, ringRow(pxy, gaussSpan, y));
+
+        bool last = (gradRows == height);
+        while (tensorRows < height && (tensorRows + gaussRadius < gradRows || last)) {
+            emitTensorRow(tensorRows++);
+        }
+    }
+
+    // Stage 3: vertical Gaussian and Harris response
+    void emitTensorRow(int y) {
+        verticalPass(pxx, gaussSpan, gauss, gaussRadius, y, &sxx[0]);
+        verticalPass(pyy, gaussSpan, gauss, gaussRadius, y, &syy[0]);
+        verticalPass(pxy, gaussSpan, gauss, gaussRadius, y, &sxy[0]);
+
+        float* r = ringRow(resp, 3, y);
+        harrisResponseRow(&sxx[0], &syy[0], &sxy[0], r, width, k);
+
+        for (int x = 0; x < width; x++) {
+            minR = std::min(minR, r[x]);
+            maxR = std::max(maxR, r[x]);
+        }
+
+        // Stage 4: a row can be tested once the row below it exists
+        if (y >= 1) emitNmsRow(y - 1);
+        if (y == height - 1) emitNmsRow(y);
+    }
+
+    void emitNmsRow(int y) {
+        const float* cur = ringRow(resp, 3, y);
+        const float* up = y > 0 ? ringRow(resp, 3, y - 1) : 0;
+        const float* down = y < height - 1 ? ringRow(resp, 3, y + 1) : 0;
+
+        for (int x = 0; x < width; x++) {
+            float v = cur[x];
+            if (v <= 0) continue;
+            int x0 = std::max(0, x - 1), x1 = std::min(width - 1, x + 1);
+            bool isMax = true;
+            for (int xx = x0; xx <= x1 && isMax; xx++) {
+                if ((xx != x && cur[xx] > v) || (up && up[xx] > v) || (down && down[xx] > v)) isMax = false;
+            }
+            if (isMax) {
+                HarrisCandidate c;
+                c.pt = cv::Point(x, y);
+                c.response = v;
+                found.push_back(c);
+            }
+        }
+        nmsRows = y + 1;
+    }
+};
+
+#endif // HARRIS_STREAM_HPP
@@ -0,0 +1,123 @@
+#ifndef IMAGE_PYRAMID_HPP
+#define IMAGE_PYRAMID_HPP
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "dog_detector.hpp"
+#include "lbp_descriptor.hpp"
+
+// Per-image product cache shared by the detectors and descriptors of
+// cvlab and cvlab_auto. Each product is built on its first request and kept,
+// so running several detector/descriptor combinations on one image
+// (cvlab_auto "all" / "m all", the interactive loops) builds it once:
+//  - level(l): pyrDown chain, level 0 is the image (harris_sparse's coarse stage)
+//  - dog(layers, sigma): SIFT Gaussian/DoG scale space (dog_detector.hpp)
+//  - lbpCodes(): 8-neighbour LBP code image (lbp_descriptor.hpp)
+//  - lbpIntegral(patch): uniform-LBP integral histogram built from lbpCodes()
+// Requests may come from several threads. Returned references stay valid for
+// the lifetime of the object, except DoG scale spaces after releaseDoG().
+// Products are never evicted on their own, which suits short-lived callers;
+// a long-lived one sweeping the DoG parameters (a doubled-resolution float
+// scale space per setting) releases the ones it no longer uses.
+
+class ImagePyramid {
+public:
+    explicit ImagePyramid(const cv::Mat& gray) : image(gray), builds(0), requests(0) {
+        CV_Assert(gray.type() == CV_8UC1);
+    }
+
+    const cv::Mat& gray() const { return image; }
+
+    const cv::Mat& level(int l) {
+        std::lock_guard<std::mutex> guard(lock);
+        requests++;
+        return levelLocked(l);
+    }
+
+    const DoGPyramid& dog(int nOctaveLayers = 3, double sigma = 1.6) {
+        std::lock_guard<std::mutex> guard(lock);
+        requests++;
+        std::pair<int, int> key(nOctaveLayers, cvRound(sigma * 1000));
+        std::map<std::pair<int, int>, DoGPyramid>::iterator it = dogs.find(key);
+        if (it != dogs.end()) return it->second;
+        builds++;
+        DoGPyramid& pyr = dogs[key];
+        buildDoGPyramid(image, pyr, nOctaveLayers, sigma);
+        return pyr;
+    }
+
+    const cv::Mat& lbpCodes() {
+        std::lock_guard<std::mutex> guard(lock);
+        requests++;
+        return lbpCodesLocked();
+    }
+
+    // Shared by every patch size that fits the same counter width
+    const LBPIntegralHistogram& lbpIntegral(int maxPatchSize = LBP_PATCH_SIZE) {
+        std::lock_guard<std::mutex> guard(lock);
+        requests++;
+        int depth = lbpIntegralDepth(maxPatchSize);
+        std::map<int, LBPIntegralHistogram>::iterator it = integrals.find(depth);
+        if (it != integrals.end()) return it->second;
+        const cv::Mat& lbp = lbpCodesLocked();
+        builds++;
+        LBPIntegralHistogram& integral = integrals[depth];
+        buildLBPIntegralHistogram(lbp, integral, maxPatchSize);
+        return integral;
+    }
+
+    // Memory of the integral histograms built so far; not counted as a request
+    size_t lbpIntegralBytes() {
+        std::lock_guard<std::mutex> guard(lock);
+        size_t bytes = 0;
+        for (std::map<int, LBPIntegralHistogram>::const_iterator it = integrals.begin(); it != integrals.end(); ++it)
+            bytes += it->second.bytes();
+        return bytes;
+    }
+
+    // Drops every cached DoG scale space; references to them become invalid
+    void releaseDoG() {
+        std::lock_guard<std::mutex> guard(lock);
+        dogs.clear();
+    }
+
+    // e.g. "3 built, 5 reused"
+    std::string describe() {
+        std::lock_guard<std::mutex> guard(lock);
+        return std::to_string(builds) + " built, " + std::to_string(requests - builds) + " reused";
+    }
+
+private:
+    const cv::Mat& lbpCodesLocked() {
+        if (codes.empty()) {
+            builds++;
+            computeLBPCodes(image, codes);
+        }
+        return codes;
+    }
+
+    const cv::Mat& levelLocked(int l) {
+        if (l <= 0) return image;
+        std::map<int, cv::Mat>::iterator it = levels.find(l);
+        if (it != levels.end()) return it->second;
+        const cv::Mat& finer = levelLocked(l - 1);
+        builds++;
+        cv::Mat& coarse = levels[l];
+        cv::pyrDown(finer, coarse);
+        return coarse;
+    }
+
+    cv::Mat image, codes;
+    std::mutex lock;
+    std::map<int, cv::Mat> levels;
+    std::map<std::pair<int, int>, DoGPyramid> dogs;
+    std::map<int, LBPIntegralHistogram> integrals;
+    int builds, requests;
+};
+
+#endif // IMAGE_PYRAMID_HPP
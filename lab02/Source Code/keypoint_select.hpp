@@ -0,0 +1,250 @@
+#ifndef KEYPOINT_SELECT_HPP
+#define KEYPOINT_SELECT_HPP
+
+#include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+// Keypoint selection shared by cvlab, cvlab_auto and exercise_d: NMS/top-K
+// on dense detector responses, plus spatially distributed selection (grid
+// bucketing + ANMS) for any detector's keypoints.
+
+// Raw-response cutoff equivalent to normalize(NORM_MINMAX, 0..255) followed
+// by threshold(normThreshold, THRESH_BINARY), without building the
+// normalized image.
+inline float normalizedThreshold(double minVal, double maxVal, double normThreshold) {
+    return (float)(minVal + normThreshold / 255.0 * (maxVal - minVal));
+}
+
+inline float normalizedThreshold(const cv::Mat& response, double normThreshold) {
+    double minVal, maxVal;
+    cv::minMaxLoc(response, &minVal, &maxVal);
+    return normalizedThreshold(minVal, maxVal, normThreshold);
+}
+
+// Target-count mode: raw-response threshold that keeps roughly the
+// `targetCount` strongest pixels, found in a single pass with no min/max
+// normalization. Positive responses are counted in a 4096-bin histogram
+// keyed on the top 12 bits of their IEEE-754 pattern (exponent + 4 mantissa
+// bits), i.e. log-spaced bins, 16 per octave, over the whole float range.
+// The cutoff is the lower edge of the bin where the count from the top
+// reaches targetCount, so "response > threshold" keeps at least targetCount
+// pixels and overshoots by at most one bin (1/32 to 1/16 of the value,
+// i.e. up to 6.25%, depending on where it falls in its octave). With fewer
+// positive pixels than targetCount it returns 0 (all positive pixels).
+inline float countThreshold(const cv::Mat& response, int targetCount) {
+    CV_Assert(response.type() == CV_32F);
+    const int shift = 19, bins = 1 << (31 - shift);
+    std::vector<int> hist(bins, 0);
+
+    for (int y = 0; y < response.rows; y++) {
+        const float* r = response.ptr<float>(y);
+        for (int x = 0; x < response.cols; x++) {
+            if (r[x] <= 0) continue;
+            unsigned int bits;
+            std::memcpy(&bits, &r[x], sizeof(bits));
+            hist[bits >> shift]++;
+        }
+    }
+
+    int total = 0;
+    for (int b = bins - 1; b > 0; b--) {
+        total += hist[b];
+        if (total >= targetCount) {
+            unsigned int edgeBits = (unsigned int)b << shift;
+            float edge;
+            std::memcpy(&edge, &edgeBits, sizeof(edge));
+            return std::nextafter(edge, 0.f);   // strict ">" keeps the edge value
+        }
+    }
+    return 0.f;
+}
+
+// Pixels of a CV_32F response above `threshold`, in raster order. One fused
+// scan in place of threshold + convertTo + findNonZero.
+inline void collectAboveThreshold(const cv::Mat& response, float threshold,
+                                  std::vector<cv::Point>& points) {
+    CV_Assert(response.type() == CV_32F);
+    points.clear();
+    for (int y = 0; y < response.rows; y++) {
+        const float* r = response.ptr<float>(y);
+        for (int x = 0; x < response.cols; x++) {
+            if (r[x] > threshold) points.push_back(cv::Point(x, y));
+        }
+    }
+}
+
+// Non-maximum suppression fused with top-K selection.
+// A pixel of the CV_32F response is kept when it is above `threshold` and is
+// the maximum of its (2*nmsRadius+1)^2 neighbourhood (radius 1 = 3x3,
+// 2 = 5x5). Survivors go straight into a bounded min-heap of maxKeypoints
+// entries, so only the strongest K are ever stored and no full sort is
+// needed. Keypoints are returned strongest first with `response` filled in.
+// maxKeypoints <= 0 keeps every local maximum; nmsRadius 0 skips suppression
+// (plain top-K of the pixels above threshold).
+inline void selectKeypointsNMS(const cv::Mat& response, float threshold, int nmsRadius,
+                               int maxKeypoints, std::vector<cv::KeyPoint>& keypoints,
+                               float keypointSize = 1.f) {
+    CV_Assert(response.type() == CV_32F);
+    keypoints.clear();
+
+    // Neighbourhood maximum of every pixel (separable, O(1) per pixel)
+    cv::Mat localMax;
+    int side = 2 * nmsRadius + 1;
+    cv::dilate(response, localMax, cv::getStructuringElement(cv::MORPH_RECT, cv::Size(side, side)));
+
+    typedef std::pair<float, cv::Point> Entry;
+    struct Stronger {
+        bool operator()(const Entry& a, const Entry& b) const { return a.first > b.first; }
+    };
+    std::priority_queue<Entry, std::vector<Entry>, Stronger> heap;   // weakest on top
+    std::vector<Entry> all;
+    const bool bounded = maxKeypoints > 0;
+
+    for (int y = 0; y < response.rows; y++) {
+        const float* r = response.ptr<float>(y);
+        const float* m = localMax.ptr<float>(y);
+        for (int x = 0; x < response.cols; x++) {
+            float v = r[x];
+            if (v <= threshold || v < m[x]) continue;
+
+            if (!bounded) {
+                all.push_back(Entry(v, cv::Point(x, y)));
+            } else if ((int)heap.size() < maxKeypoints) {
+                heap.push(Entry(v, cv::Point(x, y)));
+            } else if (v > heap.top().first) {
+                heap.pop();
+                heap.push(Entry(v, cv::Point(x, y)));
+            }
+        }
+    }
+
+    if (bounded) {
+        all.reserve(heap.size());
+        while (!heap.empty()) { all.push_back(heap.top()); heap.pop(); }
+    }
+    std::sort(all.begin(), all.end(), Stronger());   // strongest first
+
+    keypoints.reserve(all.size());
+    for (size_t i = 0; i < all.size(); i++) {
+        keypoints.push_back(cv::KeyPoint((float)all[i].second.x, (float)all[i].second.y,
+                                         keypointSize, -1, all[i].first));
+    }
+}
+
+// Keypoint order used by the selectors: higher response first, larger size
+// breaking ties (SimpleBlobDetector leaves response at 0, so blobs are ranked
+// by size).
+inline bool strongerKeypoint(const cv::KeyPoint& a, const cv::KeyPoint& b) {
+    if (a.response != b.response) return a.response > b.response;
+    return a.size > b.size;
+}
+
+// Grid bucketing: keep at most maxPerCell keypoints, strongest first, in each
+// cell of a gridSize x gridSize partition of the image. Result is sorted
+// strongest first.
+inline void gridBucketKeypoints(std::vector<cv::KeyPoint>& keypoints, cv::Size imageSize,
+                                int gridSize, int maxPerCell) {
+    std::stable_sort(keypoints.begin(), keypoints.end(), strongerKeypoint);
+    std::vector<int> count(gridSize * gridSize, 0);
+    std::vector<cv::KeyPoint> kept;
+
+    for (size_t i = 0; i < keypoints.size(); i++) {
+        int cx = std::min(gridSize - 1, std::max(0, (int)(keypoints[i].pt.x * gridSize / imageSize.width)));
+        int cy = std::min(gridSize - 1, std::max(0, (int)(keypoints[i].pt.y * gridSize / imageSize.height)));
+        if (count[cy * gridSize + cx]++ < maxPerCell) kept.push_back(keypoints[i]);
+    }
+    keypoints.swap(kept);
+}
+
+// One suppression pass for anmsKeypoints(): walk the (sorted) keypoints and
+// select each one not within Chebyshev distance `radius` of an already
+// selected keypoint. Selected points live in a uniform grid whose cells are
+// at least `radius` wide, so a query only visits the 3x3 surrounding cells.
+// Stops once `limit` keypoints are selected.
+inline void suppressByCovering(const std::vector<cv::KeyPoint>& keypoints, cv::Size imageSize,
+                               int radius, int limit, std::vector<int>& selected) {
+    selected.clear();
+    const int n = (int)keypoints.size();
+    int cellSize = (int)std::ceil(std::sqrt((double)imageSize.area() / (4.0 * n)));
+    cellSize = std::max(radius, std::max(1, cellSize));
+    const int gridW = imageSize.width / cellSize + 1, gridH = imageSize.height / cellSize + 1;
+
+    std::vector<int> head(gridW * gridH, -1), next(n, -1);   // per-cell linked lists
+    for (int i = 0; i < n && (int)selected.size() < limit; i++) {
+        const cv::Point2f& p = keypoints[i].pt;
+        int cx = std::min(gridW - 1, std::max(0, (int)p.x / cellSize));
+        int cy = std::min(gridH - 1, std::max(0, (int)p.y / cellSize));
+
+        bool covered = false;
+        for (int y = std::max(0, cy - 1); y <= std::min(gridH - 1, cy + 1) && !covered; y++) {
+            for (int x = std::max(0, cx - 1); x <= std::min(gridW - 1, cx + 1) && !covered; x++) {
+                for (int j = head[y * gridW + x]; j >= 0; j = next[j]) {
+                    const cv::Point2f& q = keypoints[j].pt;
+                    if (std::max(std::fabs(p.x - q.x), std::fabs(p.y - q.y)) < radius) {
+                        covered = true;
+                        break;
+                    }
+                }
+            }
+        }
+        if (covered) continue;
+
+        selected.push_back(i);
+        next[i] = head[cy * gridW + cx];
+        head[cy * gridW + cx] = i;
+    }
+}
+
+// Adaptive non-maximal suppression down to `budget` keypoints.
+// Finds (by binary search) the largest suppression radius that still leaves
+// `budget` keypoints, so the survivors are the strongest points that are
+// also spread out. Each radius is one grid-indexed O(n) pass, giving
+// O(n log n) overall instead of the O(n^2) pairwise radius computation.
+inline void anmsKeypoints(std::vector<cv::KeyPoint>& keypoints, cv::Size imageSize, int budget) {
+    std::stable_sort(keypoints.begin(), keypoints.end(), strongerKeypoint);
+    if (budget <= 0 || (int)keypoints.size() <= budget) return;
+
+    std::vector<int> selected, best;
+    int lo = 1, hi = std::max(imageSize.width, imageSize.height);
+    while (lo <= hi) {
+        int radius = lo + (hi - lo) / 2;
+        suppressByCovering(keypoints, imageSize, radius, budget, selected);
+        if ((int)selected.size() >= budget) {
+            best.swap(selected);
+            lo = radius + 1;
+        } else {
+            hi = radius - 1;
+        }
+    }
+
+    std::vector<cv::KeyPoint> kept;
+    if (best.empty()) {
+        // Even radius 1 leaves too few (duplicate positions): strongest first
+        kept.assign(keypoints.begin(), keypoints.begin() + budget);
+    } else {
+        for (size_t i = 0; i < best.size(); i++) kept.push_back(keypoints[best[i]]);
+    }
+    keypoints.swap(kept);
+}
+
+// Spatially distributed selection for a fixed keypoint budget: grid bucketing
+// caps any one region at twice its fair share, then ANMS spreads the budget
+// over the remaining points. Result is sorted strongest first.
+inline void distributeKeypoints(std::vector<cv::KeyPoint>& keypoints, cv::Size imageSize,
+                                int budget, int gridSize = 8) {
+    if (keypoints.empty() || imageSize.area() == 0) return;
+    int cells = gridSize * gridSize;
+    int maxPerCell = std::max(1, (2 * budget + cells - 1) / cells);
+    gridBucketKeypoints(keypoints, imageSize, gridSize, maxPerCell);
+    anmsKeypoints(keypoints, imageSize, budget);
+}
+
+#endif // KEYPOINT_SELECT_HPP
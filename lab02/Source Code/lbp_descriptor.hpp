@@ -0,0 +1,253 @@
+#ifndef LBP_DESCRIPTOR_HPP
+#define LBP_DESCRIPTOR_HPP
+
+#include <opencv2/core.hpp>
+#include <opencv2/core/hal/intrin.hpp>
+#include <opencv2/features2d.hpp>
+#include <algorithm>
+#include <vector>
+
+// Patch LBP descriptor shared by exercise_g, exercise_h, exercise_i, cvlab and
+// cvlab_auto: the 256-bin histogram of 8-neighbour LBP codes over the 40x40
+// patch (by default) around a keypoint, +1e-7 per bin, normalized to sum 1.
+//
+// computeLBPCodes codes every pixel of the image once; the histograms are then
+// read from that code image, so overlapping patches no longer recode the same
+// pixels. The result equals the former per-patch computation: a pixel on the
+// patch border has no full neighbourhood inside the patch and counts as code 0.
+//
+// LBPIntegralHistogram trades the 256 codes for the 59 uniform-LBP bins and
+// keeps one integral image per bin, so a patch histogram costs four lookups
+// per bin whatever the patch size.
+
+const int LBP_BINS = 256;
+const int LBP_PATCH_SIZE = 40;
+
+// Bit 7..0: top, top-right, right, bottom-right, bottom, bottom-left, left,
+// top-left neighbour >= center. The one-pixel image border is coded 0.
+inline void computeLBPCodes(const cv::Mat& gray, cv::Mat& codes) {
+    CV_Assert(gray.type() == CV_8UC1);
+    codes.create(gray.size(), CV_8U);
+    codes.setTo(0);
+    const int rows = gray.rows, cols = gray.cols;
+    if (rows < 3 || cols < 3) return;
+
+    cv::parallel_for_(cv::Range(1, rows - 1), [&](const cv::Range& range) {
+        for (int r = range.start; r < range.end; r++) {
+            const uchar* up = gray.ptr<uchar>(r - 1);
+            const uchar* mid = gray.ptr<uchar>(r);
+            const uchar* down = gray.ptr<uchar>(r + 1);
+            uchar* dst = codes.ptr<uchar>(r);
+            int c = 1;
+#if CV_SIMD
+            const int lanes = cv::v_uint8::nlanes;
+            cv::v_uint8 bit[8];
+            for (int b = 0; b < 8; b++) bit[b] = cv::vx_setall_u8((uchar)(1 << b));
+            // Loads reach column c + lanes, which must stay inside the row
+            for (; c + lanes < cols; c += lanes) {
+                cv::v_uint8 center = cv::vx_load(mid + c);
+                cv::v_uint8 code = (cv::vx_load(up + c) >= center) & bit[7];
+                code |= (cv::vx_load(up + c + 1) >= center) & bit[6];
+                code |= (cv::vx_load(mid + c + 1) >= center) & bit[5];
+                code |= (cv::vx_load(down + c + 1) >= center) & bit[4];
+                code |= (cv::vx_load(down + c) >= center) & bit[3];
+                code |= (cv::vx_load(down + c - 1) >= center) & bit[2];
+                code |= (cv::vx_load(mid + c - 1) >= center) & bit[1];
+                code |= (cv::vx_load(up + c - 1) >= center) & bit[0];
+                cv::v_store(dst + c, code);
+            }
+#endif
+            for (; c < cols - 1; c++) {
+                const uchar center = mid[c];
+                dst[c] = (uchar)(((up[c] >= center) << 7) | ((up[c + 1] >= center) << 6) |
+                                 ((mid[c + 1] >= center) << 5) | ((down[c + 1] >= center) << 4) |
+                                 ((down[c] >= center) << 3) | ((down[c - 1] >= center) << 2) |
+                                 ((mid[c - 1] >= center) << 1) | (up[c - 1] >= center));
+            }
+        }
+    });
+}
+
+// Patch of the keypoint at `center`, clipped to the image; false when fewer
+// than 6 columns or rows remain
+inline bool lbpPatch(const cv::Size& size, cv::Point2f center, int patchSize, cv::Rect& patch) {
+    int x = cvRound(center.x), y = cvRound(center.y);
+    int x1 = std::max(0, x - patchSize / 2), y1 = std::max(0, y - patchSize / 2);
+    int x2 = std::min(size.width, x + patchSize / 2), y2 = std::min(size.height, y + patchSize / 2);
+    if (x2 <= x1 + 5 || y2 <= y1 + 5) return false;
+    patch = cv::Rect(x1, y1, x2 - x1, y2 - y1);
+    return true;
+}
+
+// Normalized histogram of one patch into hist[0..LBP_BINS)
+inline bool lbpHistogram(const cv::Mat& codes, cv::Point2f center, float* hist,
+                         int patchSize = LBP_PATCH_SIZE) {
+    cv::Rect patch;
+    if (!lbpPatch(codes.size(), center, patchSize, patch)) return false;
+
+    int counts[LBP_BINS] = {0};
+    for (int r = patch.y + 1; r < patch.y + patch.height - 1; r++) {
+        const uchar* row = codes.ptr<uchar>(r);
+        for (int c = patch.x + 1; c < patch.x + patch.width - 1; c++) counts[row[c]]++;
+    }
+    counts[0] += patch.width * 2 + (patch.height - 2) * 2;
+
+    const float total = (float)patch.area() + LBP_BINS * 1e-7f;
+    for (int b = 0; b < LBP_BINS; b++) hist[b] = (counts[b] + 1e-7f) / total;
+    return true;
+}
+
+// One LBP_BINS-wide CV_32F row per keypoint; keypoints too close to the image
+// border for a patch get an all-zero row
+inline void computeLBPDescriptors(const cv::Mat& codes, const std::vector<cv::KeyPoint>& keypoints,
+                                  cv::Mat& descriptors, int patchSize = LBP_PATCH_SIZE) {
+    descriptors.create((int)keypoints.size(), LBP_BINS, CV_32F);
+    for (size_t i = 0; i < keypoints.size(); i++) {
+        float* row = descriptors.ptr<float>((int)i);
+        if (!lbpHistogram(codes, keypoints[i].pt, row, patchSize)) std::fill(row, row + LBP_BINS, 0.f);
+    }
+}
+
+// Uniform LBP: the 58 codes with at most two 0/1 transitions around the
+// circle keep a bin each (in code order), all others share the last bin
+const int LBP_UNIFORM_BINS = 59;
+
+inline const uchar* lbpUniformBins() {
+    static const std::vector<uchar> table = [] {
+        std::vector<uchar> bins(LBP_BINS);
+        int next = 0;
+        for (int code = 0; code < LBP_BINS; code++) {
+            int rotated = ((code >> 1) | (code << 7)) & 0xFF;
+            int transitions = 0;
+            for (int diff = code ^ rotated; diff; diff &= diff - 1) transitions++;
+            bins[code] = (uchar)(transitions <= 2 ? next++ : LBP_UNIFORM_BINS - 1);
+        }
+        return bins;
+    }();
+    return table.data();
+}
+
+// Integral histogram of the uniform bins: sums is (rows + 1) x (cols + 1) with
+// LBP_UNIFORM_BINS channels, sums(r, c)[b] counting the bin-b pixels above and
+// left of (r, c). Counts are kept modulo 2^16 (CV_16U) when every patch has
+// fewer pixels than that, else modulo 2^32 (CV_32S); patch differences are
+// exact either way.
+struct LBPIntegralHistogram {
+    cv::Mat sums;
+
+    size_t bytes() const { return sums.total() * sums.elemSize(); }
+};
+
+// Rows are split into bands that accumulate in parallel as if each started the
+// image; the band totals are then carried down, one band after the other, and
+// added to the remaining rows in parallel again.
+template<typename T>
+inline void buildLBPIntegralBands(const cv::Mat& codes, cv::Mat& sums) {
+    const int B = LBP_UNIFORM_BINS, rows = codes.rows, cols = codes.cols;
+    const int stride = (cols + 1) * B;
+    const uchar* table = lbpUniformBins();
+    std::fill(sums.ptr<T>(0), sums.ptr<T>(0) + stride, (T)0);
+    const std::vector<T> zeros(stride, (T)0);
+
+    const int nBands = std::max(1, std::min(rows, cv::getNumThreads() * 4));
+    std::vector<int> bandStart(nBands + 1);
+    for (int b = 0; b <= nBands; b++) bandStart[b] = (int)((long long)rows * b / nBands);
+
+    cv::parallel_for_(cv::Range(0, nBands), [&](const cv::Range& range) {
+        std::vector<T> run(B);
+        for (int band = range.start; band < range.end; band++) {
+            for (int r = bandStart[band]; r < bandStart[band + 1]; r++) {
+                const uchar* src = codes.ptr<uchar>(r);
+                const T* above = r == bandStart[band] ? zeros.data() : sums.ptr<T>(r);
+                T* dst = sums.ptr<T>(r + 1);
+                std::fill(run.begin(), run.end(), (T)0);
+                std::fill(dst, dst + B, (T)0);
+                for (int c = 0; c < cols; c++) {
+                    run[table[src[c]]]++;
+                    const T* up = above + (c + 1) * B;
+                    T* cell = dst + (c + 1) * B;
+                    for (int b = 0; b < B; b++) cell[b] = (T)(up[b] + run[b]);
+                }
+            }
+        }
+    });
+
+    // Last row of each band: its own total plus everything above the band
+    for (int band = 1; band < nBands; band++) {
+        const T* carry = sums.ptr<T>(bandStart[band]);
+        T* last = sums.ptr<T>(bandStart[band + 1]);
+        for (int i = 0; i < stride; i++) last[i] = (T)(last[i] + carry[i]);
+    }
+
+    cv::parallel_for_(cv::Range(1, nBands), [&](const cv::Range& range) {
+        for (int band = range.start; band < range.end; band++) {
+            const T* carry = sums.ptr<T>(bandStart[band]);
+            for (int r = bandStart[band] + 1; r < bandStart[band + 1]; r++) {
+                T* row = sums.ptr<T>(r);
+                for (int i = 0; i < stride; i++) row[i] = (T)(row[i] + carry[i]);
+            }
+        }
+    });
+}
+
+// Narrowest exact counter depth for patches up to maxPatchSize (the area is
+// taken in 64 bits: the size may come straight from the command line)
+inline int lbpIntegralDepth(int maxPatchSize) {
+    return (long long)maxPatchSize * maxPatchSize < 65536 ? CV_16U : CV_32S;
+}
+
+// From computeLBPCodes output; maxPatchSize picks the counter depth
+inline void buildLBPIntegralHistogram(const cv::Mat& codes, LBPIntegralHistogram& integral,
+                                      int maxPatchSize = LBP_PATCH_SIZE) {
+    CV_Assert(codes.type() == CV_8UC1);
+    if (lbpIntegralDepth(maxPatchSize) == CV_16U) {
+        integral.sums.create(codes.rows + 1, codes.cols + 1, CV_16UC(LBP_UNIFORM_BINS));
+        buildLBPIntegralBands<ushort>(codes, integral.sums);
+    } else {
+        integral.sums.create(codes.rows + 1, codes.cols + 1, CV_32SC(LBP_UNIFORM_BINS));
+        buildLBPIntegralBands<unsigned>(codes, integral.sums);
+    }
+}
+
+template<typename T>
+inline void lbpIntegralCounts(const cv::Mat& sums, const cv::Rect& rect, int* counts) {
+    const int B = LBP_UNIFORM_BINS;
+    const T* top = sums.ptr<T>(rect.y);
+    const T* bottom = sums.ptr<T>(rect.y + rect.height);
+    const T *a = top + rect.x * B, *b = top + (rect.x + rect.width) * B;
+    const T *c = bottom + rect.x * B, *d = bottom + (rect.x + rect.width) * B;
+    for (int i = 0; i < B; i++) counts[i] = (int)(T)(d[i] - b[i] - c[i] + a[i]);
+}
+
+// Normalized uniform histogram of one patch into hist[0..LBP_UNIFORM_BINS);
+// same patch and border handling as lbpHistogram
+inline bool lbpIntegralHistogram(const LBPIntegralHistogram& integral, cv::Point2f center, float* hist,
+                                 int patchSize = LBP_PATCH_SIZE) {
+    const cv::Mat& sums = integral.sums;
+    cv::Rect patch;
+    if (!lbpPatch(cv::Size(sums.cols - 1, sums.rows - 1), center, patchSize, patch)) return false;
+    CV_Assert(sums.depth() == CV_32S || patch.area() < 65536);
+
+    int counts[LBP_UNIFORM_BINS];
+    cv::Rect inner(patch.x + 1, patch.y + 1, patch.width - 2, patch.height - 2);
+    if (sums.depth() == CV_16U) lbpIntegralCounts<ushort>(sums, inner, counts);
+    else lbpIntegralCounts<unsigned>(sums, inner, counts);
+    counts[lbpUniformBins()[0]] += patch.area() - inner.area();
+
+    const float total = (float)patch.area() + LBP_UNIFORM_BINS * 1e-7f;
+    for (int b = 0; b < LBP_UNIFORM_BINS; b++) hist[b] = (counts[b] + 1e-7f) / total;
+    return true;
+}
+
+// One LBP_UNIFORM_BINS-wide CV_32F row per keypoint, zero rows as above
+inline void computeLBPDescriptors(const LBPIntegralHistogram& integral, const std::vector<cv::KeyPoint>& keypoints,
+                                  cv::Mat& descriptors, int patchSize = LBP_PATCH_SIZE) {
+    descriptors.create((int)keypoints.size(), LBP_UNIFORM_BINS, CV_32F);
+    for (size_t i = 0; i < keypoints.size(); i++) {
+        float* row = descriptors.ptr<float>((int)i);
+        if (!lbpIntegralHistogram(integral, keypoints[i].pt, row, patchSize))
+            std::fill(row, row + LBP_UNIFORM_BINS, 0.f);
+    }
+}
+
+#endif // LBP_DESCRIPTOR_HPP
@@ -7,15 +7,61 @@
 #include <string>
 #include <vector>
 
+#include "dog_detector.hpp"
+#include "fast_hessian.hpp"
+#include "harris_core.hpp"
+#include "harris_fixed.hpp"
+#include "harris_sparse.hpp"
+#include "image_pyramid.hpp"
+#include "keypoint_select.hpp"
+#include "lbp_descriptor.hpp"
+#include "pair_extract.hpp"
+
 using namespace cv;
 using namespace cv::xfeatures2d;
 using namespace std;
 
+// Keypoints per image for the Harris, DoG and blob detect paths; selection
+// is spread over the image with grid bucketing + ANMS (keypoint_select.hpp)
+const int KEYPOINT_BUDGET = 500;
+
+// Set by the "harris_fixed" detector name: use the fixed-point Harris path
+// (harris_fixed.hpp) where the parameters allow it
+bool harrisFixedPoint = false;
+
+// Set by the "harris_sparse" detector name: coarse-to-fine Harris
+// (harris_sparse.hpp) for the keypoint paths
+bool harrisSparse = false;
+
+// Set by the "hessian" detector name in m commands: the blob paths use the
+// Fast-Hessian detector (fast_hessian.hpp) instead of SimpleBlobDetector
+bool blobHessian = false;
+const double HESSIAN_THRESHOLD = 100;
+
+// Set by the "dog_native" detector name: the DoG paths use the in-project
+// detector (dog_detector.hpp) instead of SIFT::detect
+bool dogNative = false;
+
+// Set by the "lbp_integral" descriptor name: the LBP paths use 59-bin uniform
+// histograms read from the integral histogram (lbp_descriptor.hpp). Either
+// LBP name takes an optional ":<patch size>" suffix, e.g. lbp_integral:96
+bool lbpIntegral = false;
+int lbpPatchSize = LBP_PATCH_SIZE;
+
+// Harris response for the current mode (fixed-point or tiled float); true
+// when the fixed-point path ran
+bool harrisResponse(const Mat& gray, Mat& response, int blockSize, int apertureSize, double k) {
+    if (harrisFixedPoint && computeHarrisFixed(gray, response, blockSize, apertureSize, k)) return true;
+    computeHarrisTiled(gray, response, blockSize, apertureSize, k);
+    return false;
+}
+
 // Forward declarations
 void showHelp();
 void detectHarris(const string& imagePath);
 void detectBlob(const string& imagePath);
 void detectDoG(const string& imagePath);
+void detectHessian(const string& imagePath);
 void matchHarrisSIFT(const string& img1Path, const string& img2Path);
 void matchDoGSIFT(const string& img1Path, const string& img2Path);
 void matchBlobSIFT(const string& img1Path, const string& img2Path);
@@ -23,84 +69,76 @@ void matchHarrisLBP(const string& img1Path, const string& img2Path);
 void matchDoGLBP(const string& img1Path, const string& img2Path);
 void matchBlobLBP(const string& img1Path, const string& img2Path);
 
-// LBP descriptor computation (shared)
-Mat computeLBPDescriptor(const Mat& gray, Point2f center) {
-    int patchSize = 40;
-    int x = cvRound(center.x), y = cvRound(center.y);
-    int x1 = max(0, x - patchSize/2), y1 = max(0, y - patchSize/2);
-    int x2 = min(gray.cols, x + patchSize/2), y2 = min(gray.rows, y + patchSize/2);
-    if (x2 <= x1 + 5 || y2 <= y1 + 5) return Mat();
-    
-    Mat patch = gray(Rect(x1, y1, x2-x1, y2-y1));
-    Mat lbp = Mat::zeros(patch.size(), CV_8U);
-    
-    for (int i = 1; i < patch.rows - 1; i++) {
-        for (int j = 1; j < patch.cols - 1; j++) {
-            uchar c = patch.at<uchar>(i, j), code = 0;
-            code |= (patch.at<uchar>(i-1,j) >= c) << 7;
-            code |= (patch.at<uchar>(i-1,j+1) >= c) << 6;
-            code |= (patch.at<uchar>(i,j+1) >= c) << 5;
-            code |= (patch.at<uchar>(i+1,j+1) >= c) << 4;
-            code |= (patch.at<uchar>(i+1,j) >= c) << 3;
-            code |= (patch.at<uchar>(i+1,j-1) >= c) << 2;
-            code |= (patch.at<uchar>(i,j-1) >= c) << 1;
-            code |= (patch.at<uchar>(i-1,j-1) >= c) << 0;
-            lbp.at<uchar>(i,j) = code;
-        }
-    }
+// Coarse-to-fine Harris with the same parameters and selection as
+// detectHarrisKeypoints; full resolution only around coarse candidates (the
+// coarse stage runs on the pyramid's cached level 1)
+vector<KeyPoint> detectHarrisKeypointsSparse(ImagePyramid& pyramid) {
+    const Mat& gray = pyramid.gray();
+    HarrisSparseResult sparse;
+    computeHarrisSparse(gray, sparse, 2, 3, 0.04, 120, 64, pyramid.level(1));
     
-    int histSize = 256;
-    float range[] = {0, 256};
-    const float* histRange = {range};
-    Mat hist;
-    calcHist(&lbp, 1, 0, Mat(), hist, 1, &histSize, &histRange);
-    hist += 1e-7;
-    hist /= cv::sum(hist)[0];
-    return hist.reshape(1, 1);
+    vector<KeyPoint> keypoints;
+    float cutoff = normalizedThreshold(sparse.minResponse, sparse.maxResponse, 200);
+    selectKeypointsNMS(sparse.response, cutoff, 2, 4 * KEYPOINT_BUDGET, keypoints);
+    distributeKeypoints(keypoints, gray.size(), KEYPOINT_BUDGET);
+    return keypoints;
+}
+
+// Blob keypoints for the matching paths: SimpleBlobDetector with `params`,
+// or Fast-Hessian blobs in "hessian" mode; evenly spread over the image.
+// Safe to call from both extractPair workers (one detector per call).
+vector<KeyPoint> detectBlobKeypoints(ImagePyramid& pyramid, const SimpleBlobDetector::Params& params) {
+    const Mat& gray = pyramid.gray();
+    vector<KeyPoint> keypoints;
+    if (blobHessian) detectFastHessian(gray, keypoints, HESSIAN_THRESHOLD);
+    else SimpleBlobDetector::create(params)->detect(gray, keypoints);
+    distributeKeypoints(keypoints, gray.size(), KEYPOINT_BUDGET);
+    return keypoints;
+}
+
+// DoG keypoints with SIFT's detector parameters: SIFT::detect, or the
+// in-project detector in "dog_native" mode (same keypoints, so SIFT::compute
+// accepts them; the scale space is the pyramid's cached one). Not spread or
+// cut; safe to call from both extractPair workers.
+vector<KeyPoint> detectDoGKeypoints(ImagePyramid& pyramid, int nOctaveLayers = 3,
+                                    double contrastThreshold = 0.04, double edgeThreshold = 10) {
+    vector<KeyPoint> keypoints;
+    if (dogNative) detectDoGInPyramid(pyramid.dog(nOctaveLayers), keypoints, contrastThreshold, edgeThreshold);
+    else SIFT::create(0, nOctaveLayers, contrastThreshold, edgeThreshold)->detect(pyramid.gray(), keypoints);
+    return keypoints;
+}
+
+// LBP descriptors for the current mode, from the pyramid's cached code image
+// or integral histogram
+void describeLBP(ImagePyramid& pyramid, const vector<KeyPoint>& kp, Mat& desc) {
+    if (lbpIntegral) computeLBPDescriptors(pyramid.lbpIntegral(lbpPatchSize), kp, desc, lbpPatchSize);
+    else computeLBPDescriptors(pyramid.lbpCodes(), kp, desc, lbpPatchSize);
+}
+
+void reportLBPIntegral(ImagePyramid& pyramid1, ImagePyramid& pyramid2) {
+    if (!lbpIntegral) return;
+    size_t bytes = pyramid1.lbpIntegralBytes() + pyramid2.lbpIntegralBytes();
+    cout << "LBP integral histograms: " << bytes / (1024 * 1024) << " MB (both images, "
+         << LBP_UNIFORM_BINS << " bins, patch " << lbpPatchSize << ")" << endl;
 }
 
 // Manual Harris detection (from exercise_a)
-vector<KeyPoint> detectHarrisKeypoints(const Mat& gray) {
+vector<KeyPoint> detectHarrisKeypoints(ImagePyramid& pyramid) {
+    if (harrisSparse) return detectHarrisKeypointsSparse(pyramid);
+    const Mat& gray = pyramid.gray();
+    
     int blockSize = 2, apertureSize = 3;
     double k = 0.04;
     
-    Mat Ix, Iy;
-    Sobel(gray, Ix, CV_32F, 1, 0, apertureSize);
-    Sobel(gray, Iy, CV_32F, 0, 1, apertureSize);
-    
-    Mat Ixx, Iyy, Ixy;
-    multiply(Ix, Ix, Ixx);
-    multiply(Iy, Iy, Iyy);
-    multiply(Ix, Iy, Ixy);
-    
-    int kernelSize = blockSize * 2 + 1;
-    Mat Sxx, Syy, Sxy;
-    GaussianBlur(Ixx, Sxx, Size(kernelSize, kernelSize), 0);
-    GaussianBlur(Iyy, Syy, Size(kernelSize, kernelSize), 0);
-    GaussianBlur(Ixy, Sxy, Size(kernelSize, kernelSize), 0);
-    
-    Mat harris(gray.size(), CV_32F);
-    for (int i = 0; i < gray.rows; i++) {
-        for (int j = 0; j < gray.cols; j++) {
-            float sxx = Sxx.at<float>(i,j), syy = Syy.at<float>(i,j), sxy = Sxy.at<float>(i,j);
-            harris.at<float>(i,j) = sxx * syy - sxy * sxy - k * (sxx + syy) * (sxx + syy);
-        }
-    }
-    
-    Mat harrisNorm;
-    normalize(harris, harrisNorm, 0, 255, NORM_MINMAX);
-    Mat mask;
-    threshold(harrisNorm, mask, 200, 255, THRESH_BINARY);
-    mask.convertTo(mask, CV_8U);
-    
-    vector<Point> corners;
-    findNonZero(mask, corners);
+    // Row strips on the thread pool (or the fixed-point path)
+    Mat harris;
+    harrisResponse(gray, harris, blockSize, apertureSize, k);
     
+    // 5x5 local maxima above 200 on the normalized scale, then an evenly
+    // spread subset of the budget
     vector<KeyPoint> keypoints;
-    int limit = min(500, (int)corners.size());
-    for (int i = 0; i < limit; i++) {
-        keypoints.push_back(KeyPoint(corners[i].x, corners[i].y, 1));
-    }
+    selectKeypointsNMS(harris, normalizedThreshold(harris, 200), 2, 4 * KEYPOINT_BUDGET, keypoints);
+    distributeKeypoints(keypoints, gray.size(), KEYPOINT_BUDGET);
     return keypoints;
 }
 
@@ -111,6 +149,14 @@ int main(int argc, char** argv) {
     }
     
     string command = argv[1];
+    if (command == "harris_fixed") {
+        harrisFixedPoint = true;
+        command = "harris";
+    }
+    else if (command == "dog_native") {
+        dogNative = true;
+        command = "dog";
+    }
     
     if (command == "h") {
         showHelp();
@@ -124,11 +170,39 @@ int main(int argc, char** argv) {
     else if (command == "dog" && argc == 3) {
         detectDoG(argv[2]);
     }
+    else if (command == "hessian" && argc == 3) {
+        detectHessian(argv[2]);
+    }
     else if (command == "m" && argc >= 5) {
         string detector = argv[2];
         string descriptor = argv[3];
         string img1 = argv[4];
         string img2 = (argc >= 6) ? argv[5] : "";
+        if (detector == "harris_fixed") {
+            harrisFixedPoint = true;
+            detector = "harris";
+        }
+        else if (detector == "harris_sparse") {
+            harrisSparse = true;
+            detector = "harris";
+        }
+        else if (detector == "hessian") {
+            blobHessian = true;
+            detector = "blob";
+        }
+        else if (detector == "dog_native") {
+            dogNative = true;
+            detector = "dog";
+        }
+        size_t colon = descriptor.find(':');
+        if (colon != string::npos) {
+            lbpPatchSize = max(6, atoi(descriptor.c_str() + colon + 1));
+            descriptor = descriptor.substr(0, colon);
+        }
+        if (descriptor == "lbp_integral") {
+            lbpIntegral = true;
+            descriptor = "lbp";
+        }
         
         if (img2.empty()) {
             cerr << "Error: Two images required for matching" << endl;
@@ -175,6 +249,9 @@ void showHelp() {
     cout << "  harris <image.jpg>              - Detect Harris corners" << endl;
     cout << "  blob <image.jpg>                - Detect blobs" << endl;
     cout << "  dog <image.jpg>                 - Detect DoG keypoints" << endl;
+    cout << "  harris_fixed <image.jpg>        - Harris with the fixed-point path (aperture 3, block 1-2)" << endl;
+    cout << "  hessian <image.jpg>             - Detect Fast-Hessian (SURF-style box filter) blobs" << endl;
+    cout << "  dog_native <image.jpg>          - DoG keypoints with the in-project detector" << endl;
     cout << "\nMATCHING COMMANDS:" << endl;
     cout << "  m harris sift <img1> <img2>     - Harris + SIFT matching" << endl;
     cout << "  m dog sift <img1> <img2>        - DoG + SIFT matching" << endl;
@@ -182,6 +259,9 @@ void showHelp() {
     cout << "  m harris lbp <img1> <img2>      - Harris + LBP matching" << endl;
     cout << "  m dog lbp <img1> <img2>         - DoG + LBP matching" << endl;
     cout << "  m blob lbp <img1> <img2>        - Blob + LBP matching" << endl;
+    cout << "  (harris_fixed or harris_sparse may replace harris, hessian may replace blob," << endl;
+    cout << "   dog_native may replace dog, lbp_integral may replace lbp; both LBP names take" << endl;
+    cout << "   an optional :<patch size>, default " << LBP_PATCH_SIZE << ", e.g. m dog lbp_integral:96 ...)" << endl;
     cout << "\nOTHER:" << endl;
     cout << "  h                               - Show this help" << endl;
     cout << "\nKEYBOARD CONTROLS (in window):" << endl;
@@ -202,15 +282,17 @@ void detectHarris(const string& imagePath) {
     
     // Interactive parameters
     int blockSize = 2;
-    int apertureSize = 1; // Will be 3, 5, 7
+    int apertureSize = harrisFixedPoint ? 0 : 1; // Will be 3, 5, 7; the fixed-point path needs 3
     int kValue = 4; // k * 0.01
     int threshold = 200;
+    int targetCorners = 0; // 0 = use threshold
     
     namedWindow("Harris Detection", WINDOW_AUTOSIZE);
     createTrackbar("Block Size", "Harris Detection", &blockSize, 10);
     createTrackbar("Aperture", "Harris Detection", &apertureSize, 3);
     createTrackbar("K x100", "Harris Detection", &kValue, 10);
     createTrackbar("Threshold", "Harris Detection", &threshold, 255);
+    createTrackbar("Target Corners", "Harris Detection", &targetCorners, 5000);
     
     while (true) {
         int actualAperture = apertureSize * 2 + 3;
@@ -218,37 +300,15 @@ void detectHarris(const string& imagePath) {
         if (blockSize < 2) blockSize = 2;
         double k = (kValue + 1) / 100.0;
         
-        Mat Ix, Iy;
-        Sobel(gray, Ix, CV_32F, 1, 0, actualAperture);
-        Sobel(gray, Iy, CV_32F, 0, 1, actualAperture);
-        
-        Mat Ixx, Iyy, Ixy;
-        multiply(Ix, Ix, Ixx);
-        multiply(Iy, Iy, Iyy);
-        multiply(Ix, Iy, Ixy);
-        
-        int kernelSize = blockSize * 2 + 1;
-        Mat Sxx, Syy, Sxy;
-        GaussianBlur(Ixx, Sxx, Size(kernelSize, kernelSize), 0);
-        GaussianBlur(Iyy, Syy, Size(kernelSize, kernelSize), 0);
-        GaussianBlur(Ixy, Sxy, Size(kernelSize, kernelSize), 0);
-        
-        Mat harris(gray.size(), CV_32F);
-        for (int i = 0; i < gray.rows; i++) {
-            for (int j = 0; j < gray.cols; j++) {
-                float sxx = Sxx.at<float>(i,j), syy = Syy.at<float>(i,j), sxy = Sxy.at<float>(i,j);
-                harris.at<float>(i,j) = sxx * syy - sxy * sxy - k * (sxx + syy) * (sxx + syy);
-            }
-        }
-        
-        Mat harrisNorm;
-        normalize(harris, harrisNorm, 0, 255, NORM_MINMAX);
-        Mat mask;
-        cv::threshold(harrisNorm, mask, threshold, 255, THRESH_BINARY);
-        mask.convertTo(mask, CV_8U);
+        Mat harris;
+        bool fixedPath = harrisResponse(gray, harris, blockSize, actualAperture, k);
         
+        // Raw-response cutoff: ~N strongest pixels from a one-pass histogram,
+        // or the fixed threshold on the 0..255 normalized scale
+        float cutoff = targetCorners > 0 ? countThreshold(harris, targetCorners)
+                                         : normalizedThreshold(harris, threshold);
         vector<Point> corners;
-        findNonZero(mask, corners);
+        collectAboveThreshold(harris, cutoff, corners);
         
         Mat result = img.clone();
         for (const auto& corner : corners) {
@@ -257,6 +317,11 @@ void detectHarris(const string& imagePath) {
         
         string info = "Corners: " + to_string(corners.size());
         putText(result, info, Point(10, 30), FONT_HERSHEY_SIMPLEX, 0.7, Scalar(0, 255, 0), 2);
+        if (harrisFixedPoint) {
+            string path = fixedPath ? "Path: fixed-point"
+                                    : "Path: float (fixed-point needs aperture 3, block 2)";
+            putText(result, path, Point(10, 60), FONT_HERSHEY_SIMPLEX, 0.6, Scalar(0, 255, 0), 2);
+        }
         
         imshow("Harris Detection", result);
         
@@ -307,6 +372,7 @@ void detectBlob(const string& imagePath) {
         Ptr<SimpleBlobDetector> detector = SimpleBlobDetector::create(params);
         vector<KeyPoint> keypoints;
         detector->detect(gray, keypoints);
+        distributeKeypoints(keypoints, gray.size(), KEYPOINT_BUDGET);
         
         Mat result;
         drawKeypoints(img, keypoints, result, Scalar(0,0,255), DrawMatchesFlags::DRAW_RICH_KEYPOINTS);
@@ -343,15 +409,28 @@ void detectDoG(const string& imagePath) {
     createTrackbar("Contrast x100", "DoG Detection", &contrastThreshold, 20);
     createTrackbar("Edge Threshold", "DoG Detection", &edgeThreshold, 20);
     
+    // The scale space of the current octave layer count is kept: in dog_native
+    // mode only the extrema scan reruns for contrast and edge changes. A new
+    // layer count releases the old one, so sweeping the slider holds one.
+    ImagePyramid pyramid(gray);
+    int cachedLayers = nOctaveLayers;
     while (true) {
-        Ptr<SIFT> sift = SIFT::create(nFeatures, nOctaveLayers, contrastThreshold/100.0, edgeThreshold);
-        vector<KeyPoint> keypoints;
-        sift->detect(gray, keypoints);
+        // Detect everything, then spread "Max Features" over the image
+        // instead of SIFT's plain strongest-N cut (0 keeps all)
+        if (nOctaveLayers < 1) nOctaveLayers = 1;
+        if (nOctaveLayers != cachedLayers) {
+            pyramid.releaseDoG();
+            cachedLayers = nOctaveLayers;
+        }
+        int64 start = getTickCount();
+        vector<KeyPoint> keypoints = detectDoGKeypoints(pyramid, nOctaveLayers, contrastThreshold/100.0, edgeThreshold);
+        double ms = (getTickCount() - start) * 1000.0 / getTickFrequency();
+        if (nFeatures > 0) distributeKeypoints(keypoints, gray.size(), nFeatures);
         
         Mat result;
         drawKeypoints(img, keypoints, result, Scalar(0,0,255), DrawMatchesFlags::DRAW_RICH_KEYPOINTS);
         
-        string info = "DoG Keypoints: " + to_string(keypoints.size());
+        string info = "DoG Keypoints: " + to_string(keypoints.size()) + " (" + to_string(cvRound(ms)) + " ms)";
         putText(result, info, Point(10, 30), FONT_HERSHEY_SIMPLEX, 0.7, Scalar(0,255,0), 2);
         
         imshow("DoG Detection", result);
@@ -365,6 +444,52 @@ void detectDoG(const string& imagePath) {
     }
 }
 
+void detectHessian(const string& imagePath) {
+    Mat img = imread(imagePath, IMREAD_COLOR);
+    if (img.empty()) return;
+    
+    Mat gray;
+    cvtColor(img, gray, COLOR_BGR2GRAY);
+    
+    int threshold = (int)HESSIAN_THRESHOLD;
+    int nOctaves = 4;
+    int maxFeatures = KEYPOINT_BUDGET;
+    
+    namedWindow("Hessian Detection", WINDOW_AUTOSIZE);
+    createTrackbar("Threshold", "Hessian Detection", &threshold, 5000);
+    createTrackbar("Octaves", "Hessian Detection", &nOctaves, 5);
+    createTrackbar("Max Features", "Hessian Detection", &maxFeatures, 2000);
+    
+    while (true) {
+        if (nOctaves < 1) nOctaves = 1;
+        
+        int64 start = getTickCount();
+        vector<KeyPoint> keypoints;
+        detectFastHessian(gray, keypoints, threshold, nOctaves);
+        double ms = (getTickCount() - start) * 1000.0 / getTickFrequency();
+        if (maxFeatures > 0) distributeKeypoints(keypoints, gray.size(), maxFeatures);
+        
+        // Red: light blobs on dark, blue: dark blobs on light (Laplacian sign)
+        Mat result = img.clone();
+        for (const auto& kp : keypoints) {
+            Scalar color = kp.class_id > 0 ? Scalar(255, 0, 0) : Scalar(0, 0, 255);
+            circle(result, kp.pt, cvRound(kp.size / 2), color, 1);
+        }
+        
+        string info = "Hessian blobs: " + to_string(keypoints.size()) + " (" + to_string(cvRound(ms)) + " ms)";
+        putText(result, info, Point(10, 30), FONT_HERSHEY_SIMPLEX, 0.7, Scalar(0,255,0), 2);
+        
+        imshow("Hessian Detection", result);
+        
+        int key = waitKey(30);
+        if (key == 27 || key == 'q') break;
+        else if (key == 's') {
+            imwrite("hessian_result.jpg", result);
+            cout << "Saved hessian_result.jpg" << endl;
+        }
+    }
+}
+
 void matchHarrisSIFT(const string& img1Path, const string& img2Path) {
     Mat img1 = imread(img1Path), img2 = imread(img2Path);
     if (img1.empty() || img2.empty()) return;
@@ -373,13 +498,18 @@ void matchHarrisSIFT(const string& img1Path, const string& img2Path) {
     cvtColor(img1, gray1, COLOR_BGR2GRAY);
     cvtColor(img2, gray2, COLOR_BGR2GRAY);
     
-    vector<KeyPoint> kp1 = detectHarrisKeypoints(gray1);
-    vector<KeyPoint> kp2 = detectHarrisKeypoints(gray2);
-    
-    Ptr<SIFT> sift = SIFT::create();
+    // Detect and describe both images at once (pair_extract.hpp)
+    ImagePyramid pyramid1(gray1), pyramid2(gray2);
+    vector<KeyPoint> kp1, kp2;
     Mat desc1, desc2;
-    sift->compute(gray1, kp1, desc1);
-    sift->compute(gray2, kp2, desc2);
+    double extractMs = extractPair(pyramid1, pyramid2, kp1, kp2, desc1, desc2,
+        [](ImagePyramid& pyramid, vector<KeyPoint>& kp, Mat& desc) {
+            const Mat& gray = pyramid.gray();
+            kp = detectHarrisKeypoints(pyramid);
+            SIFT::create()->compute(gray, kp, desc);
+        });
+    cout << "Keypoints: " << kp1.size() << " / " << kp2.size()
+         << ", extraction " << extractMs << " ms (both images)" << endl;
     
     BFMatcher matcher(NORM_L2);
     vector<vector<DMatch>> knnMatches;
@@ -409,11 +539,21 @@ void matchDoGSIFT(const string& img1Path, const string& img2Path) {
     cvtColor(img1, gray1, COLOR_BGR2GRAY);
     cvtColor(img2, gray2, COLOR_BGR2GRAY);
     
-    Ptr<SIFT> sift = SIFT::create();
+    // Both images at once, one SIFT instance each
+    ImagePyramid pyramid1(gray1), pyramid2(gray2);
     vector<KeyPoint> kp1, kp2;
     Mat desc1, desc2;
-    sift->detectAndCompute(gray1, Mat(), kp1, desc1);
-    sift->detectAndCompute(gray2, Mat(), kp2, desc2);
+    double extractMs = extractPair(pyramid1, pyramid2, kp1, kp2, desc1, desc2,
+        [](ImagePyramid& pyramid, vector<KeyPoint>& kp, Mat& desc) {
+            const Mat& gray = pyramid.gray();
+            if (dogNative) {
+                kp = detectDoGKeypoints(pyramid);
+                SIFT::create()->compute(gray, kp, desc);
+            }
+            else SIFT::create()->detectAndCompute(gray, Mat(), kp, desc);
+        });
+    cout << "Keypoints: " << kp1.size() << " / " << kp2.size()
+         << ", extraction " << extractMs << " ms (both images)" << endl;
     
     BFMatcher matcher(NORM_L2);
     vector<vector<DMatch>> knnMatches;
@@ -453,15 +593,18 @@ void matchBlobSIFT(const string& img1Path, const string& img2Path) {
     params.filterByConvexity = true;
     params.minConvexity = 0.58f;
     
-    Ptr<SimpleBlobDetector> detector = SimpleBlobDetector::create(params);
+    // Both images at once, one detector each
+    ImagePyramid pyramid1(gray1), pyramid2(gray2);
     vector<KeyPoint> kp1, kp2;
-    detector->detect(gray1, kp1);
-    detector->detect(gray2, kp2);
-    
-    Ptr<SIFT> sift = SIFT::create();
     Mat desc1, desc2;
-    sift->compute(gray1, kp1, desc1);
-    sift->compute(gray2, kp2, desc2);
+    double extractMs = extractPair(pyramid1, pyramid2, kp1, kp2, desc1, desc2,
+        [&](ImagePyramid& pyramid, vector<KeyPoint>& kp, Mat& desc) {
+            const Mat& gray = pyramid.gray();
+            kp = detectBlobKeypoints(pyramid, params);
+            SIFT::create()->compute(gray, kp, desc);
+        });
+    cout << "Keypoints: " << kp1.size() << " / " << kp2.size()
+         << ", extraction " << extractMs << " ms (both images)" << endl;
     
     BFMatcher matcher(NORM_L2);
     vector<vector<DMatch>> knnMatches;
@@ -491,18 +634,18 @@ void matchHarrisLBP(const string& img1Path, const string& img2Path) {
     cvtColor(img1, gray1, COLOR_BGR2GRAY);
     cvtColor(img2, gray2, COLOR_BGR2GRAY);
     
-    vector<KeyPoint> kp1 = detectHarrisKeypoints(gray1);
-    vector<KeyPoint> kp2 = detectHarrisKeypoints(gray2);
-    
-    Mat desc1(kp1.size(), 256, CV_32F), desc2(kp2.size(), 256, CV_32F);
-    for (size_t i = 0; i < kp1.size(); i++) {
-        Mat d = computeLBPDescriptor(gray1, kp1[i].pt);
-        if (!d.empty()) d.copyTo(desc1.row(i));
-    }
-    for (size_t i = 0; i < kp2.size(); i++) {
-        Mat d = computeLBPDescriptor(gray2, kp2[i].pt);
-        if (!d.empty()) d.copyTo(desc2.row(i));
-    }
+    // Detect and describe both images at once (pair_extract.hpp)
+    ImagePyramid pyramid1(gray1), pyramid2(gray2);
+    vector<KeyPoint> kp1, kp2;
+    Mat desc1, desc2;
+    double extractMs = extractPair(pyramid1, pyramid2, kp1, kp2, desc1, desc2,
+        [](ImagePyramid& pyramid, vector<KeyPoint>& kp, Mat& desc) {
+            kp = detectHarrisKeypoints(pyramid);
+            describeLBP(pyramid, kp, desc);
+        });
+    cout << "Keypoints: " << kp1.size() << " / " << kp2.size()
+         << ", extraction " << extractMs << " ms (both images)" << endl;
+    reportLBPIntegral(pyramid1, pyramid2);
     
     vector<DMatch> good;
     for (size_t i = 0; i < kp1.size(); i++) {
@@ -535,20 +678,20 @@ void matchDoGLBP(const string& img1Path, const string& img2Path) {
     cvtColor(img1, gray1, COLOR_BGR2GRAY);
     cvtColor(img2, gray2, COLOR_BGR2GRAY);
     
-    Ptr<SIFT> sift = SIFT::create(500);
+    // Both images at once, one SIFT instance each
+    ImagePyramid pyramid1(gray1), pyramid2(gray2);
     vector<KeyPoint> kp1, kp2;
-    sift->detect(gray1, kp1);
-    sift->detect(gray2, kp2);
-    
-    Mat desc1(kp1.size(), 256, CV_32F), desc2(kp2.size(), 256, CV_32F);
-    for (size_t i = 0; i < kp1.size(); i++) {
-        Mat d = computeLBPDescriptor(gray1, kp1[i].pt);
-        if (!d.empty()) d.copyTo(desc1.row(i));
-    }
-    for (size_t i = 0; i < kp2.size(); i++) {
-        Mat d = computeLBPDescriptor(gray2, kp2[i].pt);
-        if (!d.empty()) d.copyTo(desc2.row(i));
-    }
+    Mat desc1, desc2;
+    double extractMs = extractPair(pyramid1, pyramid2, kp1, kp2, desc1, desc2,
+        [](ImagePyramid& pyramid, vector<KeyPoint>& kp, Mat& desc) {
+            const Mat& gray = pyramid.gray();
+            kp = detectDoGKeypoints(pyramid);
+            distributeKeypoints(kp, gray.size(), KEYPOINT_BUDGET);
+            describeLBP(pyramid, kp, desc);
+        });
+    cout << "Keypoints: " << kp1.size() << " / " << kp2.size()
+         << ", extraction " << extractMs << " ms (both images)" << endl;
+    reportLBPIntegral(pyramid1, pyramid2);
     
     vector<DMatch> good;
     for (size_t i = 0; i < kp1.size(); i++) {
@@ -591,20 +734,18 @@ void matchBlobLBP(const string& img1Path, const string& img2Path) {
     params.filterByConvexity = true;
     params.minConvexity = 0.58f;
     
-    Ptr<SimpleBlobDetector> detector = SimpleBlobDetector::create(params);
+    // Both images at once, one detector each
+    ImagePyramid pyramid1(gray1), pyramid2(gray2);
     vector<KeyPoint> kp1, kp2;
-    detector->detect(gray1, kp1);
-    detector->detect(gray2, kp2);
-    
-    Mat desc1(kp1.size(), 256, CV_32F), desc2(kp2.size(), 256, CV_32F);
-    for (size_t i = 0; i < kp1.size(); i++) {
-        Mat d = computeLBPDescriptor(gray1, kp1[i].pt);
-        if (!d.empty()) d.copyTo(desc1.row(i));
-    }
-    for (size_t i = 0; i < kp2.size(); i++) {
-        Mat d = computeLBPDescriptor(gray2, kp2[i].pt);
-        if (!d.empty()) d.copyTo(desc2.row(i));
-    }
+    Mat desc1, desc2;
+    double extractMs = extractPair(pyramid1, pyramid2, kp1, kp2, desc1, desc2,
+        [&](ImagePyramid& pyramid, vector<KeyPoint>& kp, Mat& desc) {
+            kp = detectBlobKeypoints(pyramid, params);
+            describeLBP(pyramid, kp, desc);
+        });
+    cout << "Keypoints: " << kp1.size() << " / " << kp2.size()
+         << ", extraction " << extractMs << " ms (both images)" << endl;
+    reportLBPIntegral(pyramid1, pyramid2);
     
     vector<DMatch> good;
     for (size_t i = 0; i < kp1.size(); i++) {
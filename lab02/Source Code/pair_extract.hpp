@@ -0,0 +1,47 @@
+#ifndef PAIR_EXTRACT_HPP
+#define PAIR_EXTRACT_HPP
+
+#include <opencv2/core.hpp>
+#include <future>
+#include <vector>
+
+// Concurrent feature extraction for the two images of a matching pair.
+//
+// extractPair() runs extract(image, keypoints, descriptors) for image 1 on a
+// std::async worker and for image 2 on the calling thread, so detection and
+// description of both images overlap. Either side may still use
+// cv::parallel_for_ internally. The two calls only share what `extract`
+// captures, so it must not write to shared state, and detector objects
+// should be created inside it (SimpleBlobDetector keeps per-call state).
+// An exception from either side is rethrown once both have finished.
+//
+// The images are usually grayscale Mats; any per-image type works (e.g. an
+// ImagePyramid, so both sides reuse their own cached levels).
+//
+// Returns the wall-clock time in milliseconds. concurrent = false runs the
+// two calls one after the other, for timing comparisons.
+template<typename Image, typename Extract>
+inline double extractPair(Image& image1, Image& image2,
+                          std::vector<cv::KeyPoint>& keypoints1, std::vector<cv::KeyPoint>& keypoints2,
+                          cv::Mat& descriptors1, cv::Mat& descriptors2,
+                          Extract extract, bool concurrent = true) {
+    int64 start = cv::getTickCount();
+    if (concurrent) {
+        std::future<void> first = std::async(std::launch::async, [&]() {
+            extract(image1, keypoints1, descriptors1);
+        });
+        try {
+            extract(image2, keypoints2, descriptors2);
+        } catch (...) {
+            first.wait();
+            throw;
+        }
+        first.get();
+    } else {
+        extract(image1, keypoints1, descriptors1);
+        extract(image2, keypoints2, descriptors2);
+    }
+    return (cv::getTickCount() - start) * 1000.0 / cv::getTickFrequency();
+}
+
+#endif // PAIR_EXTRACT_HPP
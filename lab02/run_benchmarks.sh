@@ -0,0 +1,46 @@
+#!/bin/bash
+
+# CV Lab 02 - Performance Benchmarks
+# Runs the micro-benchmarks in Release/benchmark on the landmark test images.
+# Usage: ./run_benchmarks.sh [benchmark...]   (default: all benchmarks)
+
+echo "=========================================="
+echo "CV Lab 02 - Benchmarks"
+echo "=========================================="
+
+if [ ! -f "./Release/benchmark" ]; then
+    echo "Error: benchmark not found in Release folder"
+    echo "Please run 'make' first to build the program"
+    exit 1
+fi
+
+BENCHMARKS=("response" "tiled" "box" "kernels" "fixed" "sparse" "pairs" "grouping" "levels" "components" "hessian" "dog" "lbp")
+if [ $# -gt 0 ]; then
+    BENCHMARKS=("$@")
+fi
+
+# Collect landmark images
+OBJECTS=("eiffel_tower" "pisa_tower" "statue_liberty" "big_ben" "taj_mahal")
+IMAGES=()
+for obj in "${OBJECTS[@]}"; do
+    for img in test_images/$obj/*.{jpg,png,jpeg}; do
+        [ -e "$img" ] || continue
+        IMAGES+=("$img")
+    done
+done
+
+if [ ${#IMAGES[@]} -eq 0 ]; then
+    echo "Error: no landmark images found in test_images/"
+    exit 1
+fi
+
+for bench in "${BENCHMARKS[@]}"; do
+    echo ""
+    echo "--- $bench ---"
+    ./Release/benchmark "$bench" "${IMAGES[@]}"
+done
+
+echo ""
+echo "=========================================="
+echo "Benchmarks complete"
+echo "=========================================="